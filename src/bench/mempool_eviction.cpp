@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <txmempool.h>
 
 #include <list>
@@ -131,4 +132,41 @@ static void MempoolEviction(benchmark::State& state)
     }
 }
 
+// Evict half and then all of a flood of transaction chains with varying
+// fees, as seen when a spam wave overflows -maxmempool.
+static void MempoolEvictionFlood(benchmark::State& state)
+{
+    constexpr int NUM_CHAINS{400};
+    constexpr int CHAIN_LENGTH{5};
+
+    FastRandomContext det_rand{true};
+    std::vector<std::pair<CTransactionRef, CAmount>> txs;
+    for (int c = 0; c < NUM_CHAINS; ++c) {
+        COutPoint prevout;
+        for (int l = 0; l < CHAIN_LENGTH; ++l) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout = prevout;
+            tx.vin[0].scriptSig = CScript() << c << l;
+            tx.vout.resize(1);
+            tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[0].nValue = 10 * COIN;
+            txs.emplace_back(MakeTransactionRef(tx), 1000 + det_rand.randrange(20000));
+            prevout = COutPoint(txs.back().first->GetHash(), 0);
+        }
+    }
+
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+
+    while (state.KeepRunning()) {
+        for (const auto& tx : txs) {
+            AddTx(tx.first, tx.second, pool);
+        }
+        pool.TrimToSize(pool.DynamicMemoryUsage() / 2);
+        pool.TrimToSize(0);
+    }
+}
+
 BENCHMARK(MempoolEviction, 41000);
+BENCHMARK(MempoolEvictionFlood, 20);
@@ -0,0 +1,135 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <miner.h>
+#include <pow.h>
+#include <scheduler.h>
+#include <script/sigcache.h>
+#include <script/interpreter.h>
+#include <txdb.h>
+#include <txmempool.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/thread.hpp>
+
+#include <vector>
+
+static CTransactionRef MineBlock(const CScript& coinbase_scriptPubKey)
+{
+    auto block = std::make_shared<CBlock>(BlockAssembler{Params()}.CreateNewBlock(coinbase_scriptPubKey)->block);
+    block->nTime = ::chainActive.Tip()->GetMedianTimePast() + 1;
+    block->hashMerkleRoot = BlockMerkleRoot(*block);
+
+    while (!CheckProofOfWork(block->GetHash(), block->nBits, Params().GetConsensus())) {
+        ++block->nNonce;
+        assert(block->nNonce);
+    }
+
+    bool processed{ProcessNewBlock(Params(), block, true, nullptr)};
+    assert(processed);
+
+    return block->vtx[0];
+}
+
+// Reload a mempool of signed transactions from a snapshot, with the cold
+// signature caches of a node starting up. Taken at the current tip, it
+// reinserts them without running their scripts; taken at another tip,
+// every check runs again.
+static void MempoolReload(benchmark::State& state, bool fNewTip)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+
+    // Start from a fresh chain, other benchmarks may have left one behind
+    UnloadBlockIndex();
+    InitSignatureCache();
+    InitScriptExecutionCache();
+
+    boost::thread_group thread_group;
+    CScheduler scheduler;
+    {
+        LOCK(cs_main);
+        ::pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+        ::pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
+        ::pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
+    }
+    {
+        const CChainParams& chainparams = Params();
+        thread_group.create_thread(std::bind(&CScheduler::serviceQueue, &scheduler));
+        GetMainSignals().RegisterBackgroundSignalScheduler(scheduler);
+        LoadGenesisBlock(chainparams);
+        CValidationState state;
+        ActivateBestChain(state, chainparams);
+        assert(::chainActive.Tip() != nullptr);
+    }
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript script_pub = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+
+    // Spend the coinbases of our mature blocks
+    constexpr size_t NUM_BLOCKS{200};
+    std::vector<CTransactionRef> coinbases;
+    for (size_t b{0}; b < NUM_BLOCKS; ++b) {
+        coinbases.push_back(MineBlock(script_pub));
+    }
+    {
+        LOCK(::cs_main);
+
+        for (size_t b{0}; b <= NUM_BLOCKS - COINBASE_MATURITY; ++b) {
+            CMutableTransaction tx;
+            tx.vin.emplace_back(COutPoint(coinbases[b]->GetHash(), 0));
+            tx.vout.emplace_back(coinbases[b]->vout[0].nValue - 1000, script_pub);
+            std::vector<unsigned char> sig;
+            const uint256 hash = SignatureHash(script_pub, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+            bool signed_ok{key.Sign(hash, sig)};
+            assert(signed_ok);
+            sig.push_back((unsigned char)SIGHASH_ALL);
+            tx.vin[0].scriptSig << sig;
+
+            CValidationState state;
+            bool ret{::AcceptToMemoryPool(::mempool, state, MakeTransactionRef(tx), nullptr /* pfMissingInputs */, nullptr /* plTxnReplaced */, false /* bypass_limits */, /* nAbsurdFee */ 0)};
+            assert(ret);
+        }
+    }
+    const size_t pool_size{::mempool.size()};
+    bool dumped{DumpMempool()};
+    assert(dumped);
+    if (fNewTip) {
+        ::mempool.clear();
+        MineBlock(script_pub);
+    }
+
+    while (state.KeepRunning()) {
+        ::mempool.clear();
+        InitSignatureCache();
+        InitScriptExecutionCache();
+        LoadMempool();
+        assert(::mempool.size() == pool_size);
+    }
+
+    thread_group.interrupt_all();
+    thread_group.join_all();
+    GetMainSignals().FlushBackgroundCallbacks();
+    GetMainSignals().UnregisterBackgroundSignalScheduler();
+    UnloadBlockIndex();
+}
+
+static void MempoolReloadSameTip(benchmark::State& state)
+{
+    MempoolReload(state, false);
+}
+
+static void MempoolReloadNewTip(benchmark::State& state)
+{
+    MempoolReload(state, true);
+}
+
+BENCHMARK(MempoolReloadSameTip, 10);
+BENCHMARK(MempoolReloadNewTip, 10);
@@ -0,0 +1,64 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <util/system.h>
+
+#include <thread>
+#include <vector>
+
+static const int MIN_CORES = 2;
+static const size_t CACHE_ENTRIES = 1 << 14;
+static const size_t LOOKUPS_PER_THREAD = 10000;
+
+// Mixed workload of the script check threads against the signature cache:
+// mostly lookups of signatures checked on mempool acceptance, and an insert
+// for every sixteenth lookup.
+static void SigCacheContention(benchmark::State& state, size_t shards)
+{
+    CSignatureCache cache;
+    cache.Setup(32 << 20, shards);
+
+    FastRandomContext insecure_rand(true);
+    std::vector<uint256> entries(CACHE_ENTRIES);
+    for (uint256& entry : entries) {
+        entry = insecure_rand.rand256();
+        cache.Set(entry);
+    }
+
+    const int threads = std::max(MIN_CORES, GetNumCores());
+    while (state.KeepRunning()) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&cache, &entries, t] {
+                FastRandomContext rand(uint256(std::vector<unsigned char>(32, (unsigned char)t)));
+                for (size_t i = 0; i < LOOKUPS_PER_THREAD; ++i) {
+                    if (i % 16 == 0) {
+                        cache.Set(rand.rand256());
+                    } else {
+                        cache.Get(entries[rand.randrange(entries.size())], false);
+                    }
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+static void SigCacheOneShard(benchmark::State& state)
+{
+    SigCacheContention(state, 1);
+}
+
+static void SigCacheSharded(benchmark::State& state)
+{
+    SigCacheContention(state, DEFAULT_SIGCACHE_SHARDS);
+}
+
+BENCHMARK(SigCacheOneShard, 50);
+BENCHMARK(SigCacheSharded, 50);
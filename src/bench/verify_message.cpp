@@ -0,0 +1,88 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <messagesigner.h>
+#include <random.h>
+#include <script/sigcache.h>
+
+#include <vector>
+
+static const size_t MESSAGES = 256;
+
+struct SignedMessages
+{
+    std::vector<uint256> hashes;
+    std::vector<std::vector<unsigned char>> sigs;
+    CPubKey pubkey;
+
+    explicit SignedMessages(size_t count = MESSAGES)
+    {
+        CKey key;
+        key.MakeNewKey(true);
+        pubkey = key.GetPubKey();
+        FastRandomContext insecure_rand(true);
+        for (size_t i = 0; i < count; ++i) {
+            hashes.push_back(insecure_rand.rand256());
+            sigs.emplace_back();
+            assert(CHashSigner::SignHash(hashes.back(), key, sigs.back()));
+        }
+    }
+};
+
+// Cost of a message seen for the first time: every iteration verifies a
+// message the signature cache has not seen yet.
+static void VerifyMessageFirstSeen(benchmark::State& state)
+{
+    InitSignatureCache();
+    SignedMessages messages(state.m_num_evals * state.m_num_iters);
+    std::string strError;
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        assert(CHashSigner::VerifyHash(messages.hashes[i], messages.pubkey, messages.sigs[i], strError));
+        ++i;
+    }
+}
+
+// Cost of the copies of a message relayed by other peers, which are
+// answered by the message signature cache.
+static void VerifyMessageRelayed(benchmark::State& state)
+{
+    InitSignatureCache();
+    SignedMessages messages;
+    std::string strError;
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        assert(CHashSigner::VerifyHash(messages.hashes[i], messages.pubkey, messages.sigs[i], strError));
+    }
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        assert(CHashSigner::VerifyHash(messages.hashes[i], messages.pubkey, messages.sigs[i], strError));
+        i = (i + 1) % MESSAGES;
+    }
+}
+
+// Cost of checking a relayed copy against a hash it was not signed for, as
+// pings in the legacy string format are: the recovered key is cached.
+static void VerifyMessageMismatched(benchmark::State& state)
+{
+    InitSignatureCache();
+    SignedMessages messages;
+    std::string strError;
+    CPubKey other_pubkey;
+    for (size_t i = 0; i < MESSAGES; ++i) {
+        assert(!CHashSigner::VerifyHash(messages.hashes[i], other_pubkey, messages.sigs[i], strError));
+    }
+
+    size_t i = 0;
+    while (state.KeepRunning()) {
+        assert(!CHashSigner::VerifyHash(messages.hashes[i], other_pubkey, messages.sigs[i], strError));
+        i = (i + 1) % MESSAGES;
+    }
+}
+
+BENCHMARK(VerifyMessageFirstSeen, 2000);
+BENCHMARK(VerifyMessageRelayed, 200000);
+BENCHMARK(VerifyMessageMismatched, 100000);
@@ -211,6 +211,10 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    /* Lookups answered from this cache, and lookups that went to the backing view. */
+    mutable uint64_t m_cache_hits{0};
+    mutable uint64_t m_cache_misses{0};
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -277,6 +281,12 @@ public:
     //! Calculate the size of the cache (in bytes)
     size_t DynamicMemoryUsage() const;
 
+    //! Number of coin lookups answered from this cache
+    uint64_t GetCacheHits() const { return m_cache_hits; }
+
+    //! Number of coin lookups that had to query the backing view
+    uint64_t GetCacheMisses() const { return m_cache_misses; }
+
     /**
      * Amount of bitcoins coming in to a transaction
      * Note that lightweight clients may not know anything besides the hash of previous transactions,
@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <httpserver.h>
 #include <key_io.h>
+#include <metrics.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <random.h>
@@ -256,6 +257,29 @@ void InterruptHTTPRPC()
     LogPrint(BCLog::RPC, "Interrupting HTTP RPC server\n");
 }
 
+static bool HTTPReq_Metrics(HTTPRequest* req, const std::string&)
+{
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteReply(HTTP_BAD_METHOD, "Metrics server handles only GET requests");
+        return false;
+    }
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, GetMetrics().Render());
+    return true;
+}
+
+void StartHTTPMetrics()
+{
+    LogPrint(BCLog::HTTP, "Starting HTTP metrics server\n");
+    RegisterHTTPHandler("/metrics", true, HTTPReq_Metrics);
+}
+
+void StopHTTPMetrics()
+{
+    LogPrint(BCLog::HTTP, "Stopping HTTP metrics server\n");
+    UnregisterHTTPHandler("/metrics", true);
+}
+
 void StopHTTPRPC()
 {
     LogPrint(BCLog::RPC, "Stopping HTTP RPC server\n");
@@ -32,4 +32,12 @@ void InterruptREST();
  */
 void StopREST();
 
+/** Start the HTTP metrics endpoint, serving the metrics registry at /metrics.
+ * Precondition; HTTP has been started.
+ */
+void StartHTTPMetrics();
+/** Stop the HTTP metrics endpoint.
+ */
+void StopHTTPMetrics();
+
 #endif
@@ -0,0 +1,339 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <hash.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <map>
+
+constexpr char DB_ADDRESS_HISTORY = 'h';
+constexpr char DB_ADDRESS_UNSPENT = 'u';
+constexpr char DB_ADDRESS_BALANCE = 'b';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+static uint160 ScriptHash(const CScript& script)
+{
+    return Hash160(script.begin(), script.end());
+}
+
+/**
+ * Key of a history record. The script hash comes first and the height is
+ * stored big endian, so the records of a script are adjacent and ordered by
+ * height, and LevelDB's prefix compression shares the script hash between
+ * consecutive keys.
+ */
+struct AddressHistoryKey
+{
+    uint160 script_hash;
+    int height;
+    uint256 txid;
+    uint32_t index;
+    bool spending;
+
+    AddressHistoryKey() : height(0), index(0), spending(false) {}
+    AddressHistoryKey(const uint160& script_hash_in, int height_in, const uint256& txid_in = uint256(),
+                      uint32_t index_in = 0, bool spending_in = false) :
+        script_hash(script_hash_in), height(height_in), txid(txid_in), index(index_in), spending(spending_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_HISTORY);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        s << txid;
+        ser_writedata32be(s, index);
+        ser_writedata8(s, spending);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_ADDRESS_HISTORY) {
+            throw std::ios_base::failure("Invalid format for address history key");
+        }
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        s >> txid;
+        index = ser_readdata32be(s);
+        spending = ser_readdata8(s);
+    }
+};
+
+/** Key of an unspent output record, ordered by script hash then outpoint. */
+struct AddressUnspentKey
+{
+    uint160 script_hash;
+    COutPoint outpoint;
+
+    AddressUnspentKey() {}
+    AddressUnspentKey(const uint160& script_hash_in, const COutPoint& outpoint_in) :
+        script_hash(script_hash_in), outpoint(outpoint_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_ADDRESS_UNSPENT);
+        s << script_hash;
+        s << outpoint.hash;
+        ser_writedata32be(s, outpoint.n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        if (ser_readdata8(s) != DB_ADDRESS_UNSPENT) {
+            throw std::ios_base::failure("Invalid format for address unspent key");
+        }
+        s >> script_hash;
+        s >> outpoint.hash;
+        outpoint.n = ser_readdata32be(s);
+    }
+};
+
+struct AddressHistoryValue
+{
+    //! Amount moved, stored as an absolute value
+    CAmount amount;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(amount, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+struct AddressUnspentValue
+{
+    CAmount amount;
+    int height;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(amount, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(height, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+struct AddressBalanceValue
+{
+    CAmount balance{0};
+    CAmount received{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT(balance, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(received, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ *
+ * History records map (script hash, height, txid, index, spending) to the
+ * amount moved. Unspent records map (script hash, outpoint) to the amount and
+ * height of the output, and balance records keep a running total per script
+ * so balance queries do not have to scan the history.
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the balance record of a script. Returns false if the script was never credited.
+    bool ReadBalance(const uint160& script_hash, AddressBalanceValue& value) const;
+
+    /// Read the history records of a script between two heights, inclusive.
+    bool ReadHistory(const uint160& script_hash, int start_height, int end_height, std::vector<AddressHistoryEntry>& entries);
+
+    /// Read the unspent output records of a script.
+    bool ReadUnspent(const uint160& script_hash, std::vector<AddressUnspentEntry>& entries);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AddressIndex::DB::ReadBalance(const uint160& script_hash, AddressBalanceValue& value) const
+{
+    return Read(std::make_pair(DB_ADDRESS_BALANCE, script_hash), value);
+}
+
+bool AddressIndex::DB::ReadHistory(const uint160& script_hash, int start_height, int end_height, std::vector<AddressHistoryEntry>& entries)
+{
+    std::unique_ptr<CDBIterator> cursor(NewIterator());
+    AddressHistoryKey key;
+    for (cursor->Seek(AddressHistoryKey(script_hash, start_height)); cursor->Valid(); cursor->Next()) {
+        if (!cursor->GetKey(key) || key.script_hash != script_hash || key.height > end_height) {
+            break;
+        }
+        AddressHistoryValue value;
+        if (!cursor->GetValue(value)) {
+            return error("%s: cannot parse address history record", __func__);
+        }
+        entries.push_back({key.height, key.txid, key.index, key.spending, key.spending ? -value.amount : value.amount});
+    }
+    return true;
+}
+
+bool AddressIndex::DB::ReadUnspent(const uint160& script_hash, std::vector<AddressUnspentEntry>& entries)
+{
+    std::unique_ptr<CDBIterator> cursor(NewIterator());
+    AddressUnspentKey key;
+    for (cursor->Seek(AddressUnspentKey(script_hash, COutPoint(uint256(), 0))); cursor->Valid(); cursor->Next()) {
+        if (!cursor->GetKey(key) || key.script_hash != script_hash) {
+            break;
+        }
+        AddressUnspentValue value;
+        if (!cursor->GetValue(value)) {
+            return error("%s: cannot parse address unspent record", __func__);
+        }
+        entries.push_back({key.outpoint, value.amount, value.height});
+    }
+    return true;
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::UpdateBlock(const CBlock& block, const CBlockIndex* pindex, bool connect)
+{
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    if (block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: undo data of block %s does not match", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(*m_db);
+    std::map<uint160, AddressBalanceValue> balance_deltas;
+
+    // Disconnecting walks the block backwards, so an output spent within the
+    // block is restored by its spender before its creator erases it.
+    const size_t n_txs = block.vtx.size();
+    for (size_t n = 0; n < n_txs; n++) {
+        const size_t i = connect ? n : n_txs - 1 - n;
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        for (uint32_t j = 0; j < tx.vout.size(); j++) {
+            const CTxOut& out = tx.vout[j];
+            if (out.scriptPubKey.IsUnspendable()) continue;
+            const uint160 script_hash = ScriptHash(out.scriptPubKey);
+            const AddressHistoryKey history_key(script_hash, pindex->nHeight, txid, j, false);
+            const AddressUnspentKey unspent_key(script_hash, COutPoint(txid, j));
+            AddressBalanceValue& delta = balance_deltas[script_hash];
+            if (connect) {
+                batch.Write(history_key, AddressHistoryValue{out.nValue});
+                batch.Write(unspent_key, AddressUnspentValue{out.nValue, pindex->nHeight});
+                delta.balance += out.nValue;
+                delta.received += out.nValue;
+            } else {
+                batch.Erase(history_key);
+                batch.Erase(unspent_key);
+                delta.balance -= out.nValue;
+                delta.received -= out.nValue;
+            }
+        }
+
+        if (tx.IsCoinBase()) continue;
+        const CTxUndo& tx_undo = block_undo.vtxundo[i - 1];
+        for (uint32_t j = 0; j < tx.vin.size(); j++) {
+            const Coin& coin = tx_undo.vprevout[j];
+            const uint160 script_hash = ScriptHash(coin.out.scriptPubKey);
+            const AddressHistoryKey history_key(script_hash, pindex->nHeight, txid, j, true);
+            const AddressUnspentKey unspent_key(script_hash, tx.vin[j].prevout);
+            AddressBalanceValue& delta = balance_deltas[script_hash];
+            if (connect) {
+                batch.Write(history_key, AddressHistoryValue{coin.out.nValue});
+                batch.Erase(unspent_key);
+                delta.balance -= coin.out.nValue;
+            } else {
+                batch.Erase(history_key);
+                batch.Write(unspent_key, AddressUnspentValue{coin.out.nValue, static_cast<int>(coin.nHeight)});
+                delta.balance += coin.out.nValue;
+            }
+        }
+    }
+
+    for (const auto& entry : balance_deltas) {
+        AddressBalanceValue value;
+        m_db->ReadBalance(entry.first, value);
+        value.balance += entry.second.balance;
+        value.received += entry.second.received;
+        if (value.balance < 0 || value.received < 0) {
+            return error("%s: negative balance for script %s", __func__, entry.first.ToString());
+        }
+        if (value.received == 0) {
+            batch.Erase(std::make_pair(DB_ADDRESS_BALANCE, entry.first));
+        } else {
+            batch.Write(std::make_pair(DB_ADDRESS_BALANCE, entry.first), value);
+        }
+    }
+
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (pindex->nHeight == 0) return true;
+
+    return UpdateBlock(block, pindex, true);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!UpdateBlock(block, pindex, false)) {
+            return error("%s: Failed to revert block %s from index",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::FindHistory(const CScript& script, int start_height, int end_height, std::vector<AddressHistoryEntry>& entries) const
+{
+    return m_db->ReadHistory(ScriptHash(script), start_height, end_height, entries);
+}
+
+bool AddressIndex::FindUnspent(const CScript& script, std::vector<AddressUnspentEntry>& entries) const
+{
+    return m_db->ReadUnspent(ScriptHash(script), entries);
+}
+
+bool AddressIndex::FindBalance(const CScript& script, CAmount& balance, CAmount& received) const
+{
+    AddressBalanceValue value;
+    m_db->ReadBalance(ScriptHash(script), value);
+    balance = value.balance;
+    received = value.received;
+    return true;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <script/script.h>
+
+#include <vector>
+
+static const bool DEFAULT_ADDRESSINDEX = false;
+
+/** A credit to or debit from a script recorded in the address index. */
+struct AddressHistoryEntry
+{
+    int height;
+    uint256 txid;
+    //! Output index, or input index when spending
+    uint32_t index;
+    bool spending;
+    //! Negative when spending
+    CAmount amount;
+};
+
+/** An output paying to a script that was unspent at the index tip. */
+struct AddressUnspentEntry
+{
+    COutPoint outpoint;
+    CAmount amount;
+    int height;
+};
+
+/**
+ * AddressIndex is used to look up the history, balance and unspent outputs
+ * of a scriptPubKey. The index is written to a LevelDB database and keyed by
+ * the hash of the script, so that all records of a script are adjacent.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    /// Apply or revert the index entries of a block.
+    bool UpdateBlock(const CBlock& block, const CBlockIndex* pindex, bool connect);
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up the credits and debits of a script between two heights, inclusive.
+    bool FindHistory(const CScript& script, int start_height, int end_height, std::vector<AddressHistoryEntry>& entries) const;
+
+    /// Look up the outputs paying to a script that are unspent.
+    bool FindUnspent(const CScript& script, std::vector<AddressUnspentEntry>& entries) const;
+
+    /// Look up the current balance of a script and the total it has received.
+    bool FindBalance(const CScript& script, CAmount& balance, CAmount& received) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
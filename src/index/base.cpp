@@ -11,10 +11,17 @@
 #include <validation.h>
 #include <warnings.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
 constexpr char DB_BEST_BLOCK = 'B';
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+constexpr int MAX_SYNC_READ_THREADS = 8;
+constexpr size_t SYNC_READ_AHEAD = 128; // blocks
 
 template<typename... Args>
 static void FatalError(const char* fmt, const Args&... args)
@@ -85,14 +92,137 @@ static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev) EXCLUSIV
     return chainActive.Next(chainActive.FindFork(pindex_prev));
 }
 
+namespace {
+/**
+ * Blocks queued for an index to catch up with, read from disk by a pool of
+ * threads. Reading dominates the sync (each block is deserialized and its
+ * proof of work hashed again), while the writes must follow chain order, so
+ * the readers run ahead of the writer by up to SYNC_READ_AHEAD blocks.
+ */
+class BlockReadQueue
+{
+private:
+    struct Entry
+    {
+        const CBlockIndex* pindex;
+        std::shared_ptr<CBlock> block;
+        bool claimed = false;
+        bool done = false;
+        bool ok = false;
+    };
+
+    const Consensus::Params& m_consensus_params;
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Entry> m_entries GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex) = false;
+    std::vector<std::thread> m_threads;
+
+    void ThreadRead()
+    {
+        WAIT_LOCK(m_mutex, lock);
+        while (!m_stop) {
+            auto it = std::find_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return !entry.claimed; });
+            if (it == m_entries.end()) {
+                m_cond.wait(lock);
+                continue;
+            }
+            // Only entries that are done get popped, and pushing or popping
+            // at the ends of a deque leaves references to the others valid.
+            Entry& entry = *it;
+            entry.claimed = true;
+
+            const CBlockIndex* pindex = entry.pindex;
+            std::shared_ptr<CBlock> block = std::make_shared<CBlock>();
+            lock.unlock();
+            const bool ok = ReadBlockFromDisk(*block, pindex, m_consensus_params);
+            lock.lock();
+
+            entry.block = std::move(block);
+            entry.ok = ok;
+            entry.done = true;
+            m_cond.notify_all();
+        }
+    }
+
+public:
+    BlockReadQueue(const char* name, const Consensus::Params& consensus_params, int n_threads)
+        : m_consensus_params(consensus_params)
+    {
+        for (int i = 0; i < n_threads; ++i) {
+            m_threads.emplace_back(&TraceThread<std::function<void()>>, name, std::bind(&BlockReadQueue::ThreadRead, this));
+        }
+    }
+
+    ~BlockReadQueue()
+    {
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    bool Full()
+    {
+        LOCK(m_mutex);
+        return m_entries.size() >= SYNC_READ_AHEAD;
+    }
+
+    bool Empty()
+    {
+        LOCK(m_mutex);
+        return m_entries.empty();
+    }
+
+    void Push(const CBlockIndex* pindex)
+    {
+        {
+            LOCK(m_mutex);
+            Entry entry;
+            entry.pindex = pindex;
+            m_entries.push_back(std::move(entry));
+        }
+        m_cond.notify_one();
+    }
+
+    /**
+     * Wait for the first queued block to be read, then pop it and every
+     * following block that is also read. Returns false if a block could not
+     * be read, leaving its index in pindex_failed.
+     */
+    bool PopRead(std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks, const CBlockIndex*& pindex_failed)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_cond.wait(lock, [this] { return m_entries.empty() || m_entries.front().done; });
+        while (!m_entries.empty() && m_entries.front().done) {
+            Entry& entry = m_entries.front();
+            if (!entry.ok) {
+                pindex_failed = entry.pindex;
+                return false;
+            }
+            blocks.emplace_back(std::move(entry.block), entry.pindex);
+            m_entries.pop_front();
+        }
+        return true;
+    }
+};
+} // namespace
+
 void BaseIndex::ThreadSync()
 {
     const CBlockIndex* pindex = m_best_block_index.load();
     if (!m_synced) {
-        auto& consensus_params = Params().GetConsensus();
+        const int n_threads = std::max(1, std::min(GetNumCores() - 1, MAX_SYNC_READ_THREADS));
+        BlockReadQueue queue(GetName(), Params().GetConsensus(), n_threads);
 
+        // The last block handed to the readers; pindex is the last one written.
+        const CBlockIndex* pindex_queued = pindex;
         int64_t last_log_time = 0;
-        int64_t last_locator_write_time = 0;
+        int64_t last_locator_write_time = GetTime();
         while (true) {
             if (m_interrupt) {
                 WriteBestBlock(pindex);
@@ -101,15 +231,51 @@ void BaseIndex::ThreadSync()
 
             {
                 LOCK(cs_main);
-                const CBlockIndex* pindex_next = NextSyncBlock(pindex);
-                if (!pindex_next) {
-                    WriteBestBlock(pindex);
-                    m_best_block_index = pindex;
-                    m_synced = true;
-                    break;
+                while (!queue.Full()) {
+                    const CBlockIndex* pindex_next = NextSyncBlock(pindex_queued);
+                    if (!pindex_next) {
+                        if (queue.Empty()) {
+                            WriteBestBlock(pindex);
+                            m_best_block_index = pindex;
+                            m_synced = true;
+                        }
+                        break;
+                    }
+                    if (pindex_queued && pindex_next->pprev != pindex_queued) {
+                        // Write what was queued of the stale branch, so that
+                        // rewinding starts from the last written block.
+                        if (queue.Empty()) {
+                            if (!Rewind(pindex, pindex_next->pprev)) {
+                                FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                                           __func__, GetName());
+                                return;
+                            }
+                            pindex = pindex_queued = pindex_next->pprev;
+                            continue;
+                        }
+                        break;
+                    }
+                    queue.Push(pindex_next);
+                    pindex_queued = pindex_next;
                 }
-                pindex = pindex_next;
             }
+            if (m_synced) break;
+
+            std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>> blocks;
+            const CBlockIndex* pindex_failed = nullptr;
+            if (!queue.PopRead(blocks, pindex_failed)) {
+                FatalError("%s: Failed to read block %s from disk",
+                           __func__, pindex_failed->GetBlockHash().ToString());
+                return;
+            }
+            if (blocks.empty()) continue;
+            if (!WriteBlocks(blocks)) {
+                FatalError("%s: Failed to write blocks %s to %s to index database",
+                           __func__, blocks.front().second->GetBlockHash().ToString(),
+                           blocks.back().second->GetBlockHash().ToString());
+                return;
+            }
+            pindex = blocks.back().second;
 
             int64_t current_time = GetTime();
             if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
@@ -122,18 +288,6 @@ void BaseIndex::ThreadSync()
                 WriteBestBlock(pindex);
                 last_locator_write_time = current_time;
             }
-
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
-                FatalError("%s: Failed to read block %s from disk",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            }
-            if (!WriteBlock(block, pindex)) {
-                FatalError("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            }
         }
     }
 
@@ -153,6 +307,23 @@ bool BaseIndex::WriteBestBlock(const CBlockIndex* block_index)
     return true;
 }
 
+bool BaseIndex::WriteBlocks(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks)
+{
+    for (const auto& entry : blocks) {
+        if (!WriteBlock(*entry.first, entry.second)) return false;
+    }
+    return true;
+}
+
+bool BaseIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // In the case of a reorg, ensure persisted block locator is not stale.
+    m_best_block_index = new_tip;
+    return WriteBestBlock(new_tip);
+}
+
 void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
                                const std::vector<CTransactionRef>& txn_conflicted)
 {
@@ -180,6 +351,13 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
                       best_block_index->GetBlockHash().ToString());
             return;
         }
+
+        // Undo the blocks of a stale branch before appending the new one.
+        if (best_block_index != pindex->pprev && !Rewind(best_block_index, pindex->pprev)) {
+            FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                       __func__, GetName());
+            return;
+        }
     }
 
     if (WriteBlock(*block, pindex)) {
@@ -12,6 +12,10 @@
 #include <uint256.h>
 #include <validationinterface.h>
 
+#include <memory>
+#include <utility>
+#include <vector>
+
 class CBlockIndex;
 
 /**
@@ -49,9 +53,10 @@ private:
 
     /// Sync the index with the block index starting from the current best block.
     /// Intended to be run in its own thread, m_thread_sync, and can be
-    /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
-    /// flag is set and the BlockConnected ValidationInterface callback takes
-    /// over and the sync thread exits.
+    /// interrupted with m_interrupt. Blocks are read from disk by several
+    /// reader threads and written in chain order by this one. Once the index
+    /// gets in sync, the m_synced flag is set and the BlockConnected
+    /// ValidationInterface callback takes over and the sync thread exits.
     void ThreadSync();
 
     /// Write the current chain block locator to the DB.
@@ -69,6 +74,16 @@ protected:
     /// Write update index entries for a newly connected block.
     virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
 
+    /// Write update index entries for a run of consecutive blocks while
+    /// catching up with the chain. The default writes them one at a time;
+    /// indexes whose entries for a block do not depend on earlier blocks can
+    /// write the whole run in one database batch.
+    virtual bool WriteBlocks(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks);
+
+    /// Rewind index to an earlier chain tip during a chain reorg. The tip must
+    /// be an ancestor of the current best block.
+    virtual bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
+
     virtual DB& GetDB() const = 0;
 
     /// Get the name of the index for display in logs.
@@ -0,0 +1,144 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/spentindex.h>
+#include <util/system.h>
+#include <validation.h>
+
+constexpr char DB_SPENTINDEX = 's';
+
+std::unique_ptr<SpentIndex> g_spentindex;
+
+struct SpentIndexValue
+{
+    uint256 txid;
+    uint32_t input_index;
+    int height;
+
+    SpentIndexValue() : input_index(0), height(0) {}
+    SpentIndexValue(const uint256& txid_in, uint32_t input_index_in, int height_in) :
+        txid(txid_in), input_index(input_index_in), height(height_in) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(VARINT(input_index));
+        READWRITE(VARINT(height, VarIntMode::NONNEGATIVE_SIGNED));
+    }
+};
+
+/**
+ * Access to the spent output index database (indexes/spentindex/)
+ *
+ * Maps every outpoint spent in the indexed chain to the transaction, input
+ * index and height of its spender.
+ */
+class SpentIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the spender of an outpoint. Returns false if the outpoint is not indexed.
+    bool ReadSpender(const COutPoint& outpoint, SpentIndexValue& value) const;
+
+    /// Write or erase the spenders of the inputs of a block.
+    bool WriteBlockSpenders(const CBlock& block, int height, bool connect);
+
+    /// Write the spenders of the inputs of consecutive blocks in one batch.
+    bool WriteBlocksSpenders(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks);
+};
+
+SpentIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool SpentIndex::DB::ReadSpender(const COutPoint& outpoint, SpentIndexValue& value) const
+{
+    return Read(std::make_pair(DB_SPENTINDEX, outpoint), value);
+}
+
+static void BatchBlockSpenders(CDBBatch& batch, const CBlock& block, int height, bool connect)
+{
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        const uint256& txid = tx->GetHash();
+        for (uint32_t i = 0; i < tx->vin.size(); i++) {
+            const auto key = std::make_pair(DB_SPENTINDEX, tx->vin[i].prevout);
+            if (connect) {
+                batch.Write(key, SpentIndexValue(txid, i, height));
+            } else {
+                batch.Erase(key);
+            }
+        }
+    }
+}
+
+bool SpentIndex::DB::WriteBlockSpenders(const CBlock& block, int height, bool connect)
+{
+    CDBBatch batch(*this);
+    BatchBlockSpenders(batch, block, height, connect);
+    return WriteBatch(batch);
+}
+
+bool SpentIndex::DB::WriteBlocksSpenders(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks)
+{
+    CDBBatch batch(*this);
+    for (const auto& entry : blocks) {
+        BatchBlockSpenders(batch, *entry.first, entry.second->nHeight, true);
+    }
+    return WriteBatch(batch);
+}
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<SpentIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+SpentIndex::~SpentIndex() {}
+
+bool SpentIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    return m_db->WriteBlockSpenders(block, pindex->nHeight, true);
+}
+
+bool SpentIndex::WriteBlocks(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks)
+{
+    return m_db->WriteBlocksSpenders(blocks);
+}
+
+bool SpentIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!m_db->WriteBlockSpenders(block, pindex->nHeight, false)) {
+            return error("%s: Failed to revert block %s from index",
+                         __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& SpentIndex::GetDB() const { return *m_db; }
+
+bool SpentIndex::FindSpender(const COutPoint& outpoint, SpentIndexEntry& entry) const
+{
+    SpentIndexValue value;
+    if (!m_db->ReadSpender(outpoint, value)) {
+        return false;
+    }
+    entry.txid = value.txid;
+    entry.input_index = value.input_index;
+    entry.height = value.height;
+    return true;
+}
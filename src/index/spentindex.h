@@ -0,0 +1,63 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SPENTINDEX_H
+#define BITCOIN_INDEX_SPENTINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+
+static const bool DEFAULT_SPENTINDEX = false;
+
+/** The input of the active chain that spends an outpoint. */
+struct SpentIndexEntry
+{
+    uint256 txid;
+    uint32_t input_index;
+    int height;
+};
+
+/**
+ * SpentIndex is used to look up the transaction spending an outpoint. The
+ * index is written to a LevelDB database and records the spending input of
+ * every outpoint spent in the active chain.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool WriteBlocks(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~SpentIndex() override;
+
+    /// Look up the input spending an outpoint.
+    ///
+    /// @param[in]   outpoint  The spent outpoint.
+    /// @param[out]  entry  The spending transaction, input index and block height.
+    /// @return  true if the outpoint is spent in the indexed chain, false otherwise
+    bool FindSpender(const COutPoint& outpoint, SpentIndexEntry& entry) const;
+};
+
+/// The global spent output index. May be null.
+extern std::unique_ptr<SpentIndex> g_spentindex;
+
+#endif // BITCOIN_INDEX_SPENTINDEX_H
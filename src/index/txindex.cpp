@@ -243,18 +243,32 @@ bool TxIndex::Init()
     return BaseIndex::Init();
 }
 
-bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+static void AppendTxPositions(const CBlock& block, const CBlockIndex* pindex, std::vector<std::pair<uint256, CDiskTxPos>>& vPos)
 {
     // Exclude genesis block transaction because outputs are not spendable.
-    if (pindex->nHeight == 0) return true;
+    if (pindex->nHeight == 0) return;
 
     CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
-    vPos.reserve(block.vtx.size());
     for (const auto& tx : block.vtx) {
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
     }
+}
+
+bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
+    vPos.reserve(block.vtx.size());
+    AppendTxPositions(block, pindex, vPos);
+    return m_db->WriteTxs(vPos);
+}
+
+bool TxIndex::WriteBlocks(const std::vector<std::pair<std::shared_ptr<const CBlock>, const CBlockIndex*>>& blocks)
+{
+    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
+    for (const auto& entry : blocks) {
+        AppendTxPositions(*entry.first, entry.second, vPos);
+    }
     return m_db->WriteTxs(vPos);
 }
 
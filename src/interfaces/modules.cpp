@@ -4,6 +4,7 @@
 
 #include <chainparams.h>
 #include <interfaces/modules.h>
+#include <metrics.h>
 #include <modules/platform/funding.h>
 #include <modules/masternode/masternode_man.h>
 #include <modules/masternode/masternode_payments.h>
@@ -17,33 +18,54 @@ void ModuleInterface::InitializeCurrentBlockTip()
     UpdatedBlockTip(chainActive.Tip(), nullptr, IsInitialBlockDownload());
 }
 
+/** Time spent by one module processing network messages. */
+static MetricHistogram& MessageHistogram(const char* module)
+{
+    return GetMetrics().Histogram("chaincoin_module_message_process_seconds", "Time spent by the modules processing network messages", "module", module);
+}
+
+/** Time spent by one module handling a new chain tip. */
+static MetricHistogram& BlockTipHistogram(const char* module)
+{
+    return GetMetrics().Histogram("chaincoin_module_block_tip_seconds", "Time spent by the modules handling a new chain tip", "module", module);
+}
+
+static MetricHistogram& g_funding_message_time = MessageHistogram("funding");
+static MetricHistogram& g_mnman_message_time = MessageHistogram("masternodeman");
+static MetricHistogram& g_mnsync_message_time = MessageHistogram("masternodesync");
+static MetricHistogram& g_mnpay_message_time = MessageHistogram("masternodepayments");
+static MetricHistogram& g_coinjoin_message_time = MessageHistogram("coinjoin");
+
+static MetricHistogram& g_funding_tip_time = BlockTipHistogram("funding");
+static MetricHistogram& g_mnman_tip_time = BlockTipHistogram("masternodeman");
+static MetricHistogram& g_mnsync_tip_time = BlockTipHistogram("masternodesync");
+static MetricHistogram& g_mnpay_tip_time = BlockTipHistogram("masternodepayments");
+static MetricHistogram& g_coinjoin_tip_time = BlockTipHistogram("coinjoin");
+
 void ModuleInterface::ProcessModuleMessage(CNode* pfrom, const NetMsgDest& dest, const std::string& strCommand, CDataStream& vRecv, CConnman* connman)
 {
     CDataStream ss(vRecv);
 
-    switch (dest) {
-    case NetMsgDest::MSG_NONE:
-        return;
-    case NetMsgDest::MSG_FUND:
-        funding.ProcessModuleMessage(pfrom, strCommand, ss, connman);
-        return;
-    case NetMsgDest::MSG_MN_MAN:
-        mnodeman.ProcessModuleMessage(pfrom, strCommand, ss, connman);
-        return;
-    case NetMsgDest::MSG_MN_SYNC:
-        masternodeSync.ProcessModuleMessage(pfrom, strCommand, ss);
-        return;
-    case NetMsgDest::MSG_MN_PAY:
-        mnpayments.ProcessModuleMessage(pfrom, strCommand, ss, connman);
-        return;
-    case NetMsgDest::MSG_PSEND:
-        coinJoinServer.ProcessModuleMessage(pfrom, strCommand, ss, connman);
-        return;
-    case NetMsgDest::MSG_ALL:
+    if (dest == NetMsgDest::MSG_NONE) return;
+
+    if (dest == NetMsgDest::MSG_FUND || dest == NetMsgDest::MSG_ALL) {
+        MetricTimer timer(g_funding_message_time);
         funding.ProcessModuleMessage(pfrom, strCommand, ss, connman);
+    }
+    if (dest == NetMsgDest::MSG_MN_MAN || dest == NetMsgDest::MSG_ALL) {
+        MetricTimer timer(g_mnman_message_time);
         mnodeman.ProcessModuleMessage(pfrom, strCommand, ss, connman);
+    }
+    if (dest == NetMsgDest::MSG_MN_SYNC || dest == NetMsgDest::MSG_ALL) {
+        MetricTimer timer(g_mnsync_message_time);
         masternodeSync.ProcessModuleMessage(pfrom, strCommand, ss);
+    }
+    if (dest == NetMsgDest::MSG_MN_PAY || dest == NetMsgDest::MSG_ALL) {
+        MetricTimer timer(g_mnpay_message_time);
         mnpayments.ProcessModuleMessage(pfrom, strCommand, ss, connman);
+    }
+    if (dest == NetMsgDest::MSG_PSEND || dest == NetMsgDest::MSG_ALL) {
+        MetricTimer timer(g_coinjoin_message_time);
         coinJoinServer.ProcessModuleMessage(pfrom, strCommand, ss, connman);
     }
 }
@@ -53,13 +75,27 @@ void ModuleInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlock
     if (pindexNew == pindexFork) // blocks were disconnected without any new ones
         return;
 
-    masternodeSync.UpdatedBlockTip(pindexNew, fInitialDownload, connman);
+    {
+        MetricTimer timer(g_mnsync_tip_time);
+        masternodeSync.UpdatedBlockTip(pindexNew, fInitialDownload, connman);
+    }
 
     if (fLiteMode || fInitialDownload) return;
 
-    coinJoinServer.UpdatedBlockTip(pindexNew);
-    mnodeman.UpdatedBlockTip(pindexNew);
-    mnpayments.UpdatedBlockTip(pindexNew, fInitialDownload, connman);
-    funding.UpdatedBlockTip(pindexNew, fInitialDownload, connman);
+    {
+        MetricTimer timer(g_coinjoin_tip_time);
+        coinJoinServer.UpdatedBlockTip(pindexNew);
+    }
+    {
+        MetricTimer timer(g_mnman_tip_time);
+        mnodeman.UpdatedBlockTip(pindexNew);
+    }
+    {
+        MetricTimer timer(g_mnpay_tip_time);
+        mnpayments.UpdatedBlockTip(pindexNew, fInitialDownload, connman);
+    }
+    {
+        MetricTimer timer(g_funding_tip_time);
+        funding.UpdatedBlockTip(pindexNew, fInitialDownload, connman);
+    }
 }
-
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <logging.h>
+#include <util/system.h>
 #include <util/time.h>
 
 const char * const DEFAULT_DEBUGLOGFILE = "debug.log";
@@ -36,6 +37,81 @@ static int FileWriteStr(const std::string &str, FILE *fp)
     return fwrite(str.data(), 1, str.size(), fp);
 }
 
+/**
+ * Lock-free bounded queue with many producers and a single consumer.
+ *
+ * Each slot carries a sequence number telling whose turn it is: a producer
+ * claims position pos by advancing m_head while the slot's sequence equals
+ * pos, and publishes the message by setting it to pos + 1. The consumer
+ * takes the message once the sequence reads pos + 1 and hands the slot to
+ * the next lap of producers by setting it to pos + capacity.
+ */
+class BCLog::Logger::MessageQueue
+{
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        std::string msg;
+    };
+
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<size_t> m_head{0};
+    //! Only accessed by the consumer
+    size_t m_tail = 0;
+
+public:
+    explicit MessageQueue(size_t capacity) : m_mask(capacity - 1), m_slots(new Slot[capacity])
+    {
+        assert(capacity > 0 && (capacity & m_mask) == 0);
+        for (size_t i = 0; i < capacity; i++) {
+            m_slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /** Append a message. Returns false if the queue is full. */
+    bool TryPush(std::string&& msg)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &m_slots[pos & m_mask];
+            const size_t seq = slot->seq.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        slot->msg = std::move(msg);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Take the oldest message. Returns false if there is none. */
+    bool TryPop(std::string& msg)
+    {
+        Slot& slot = m_slots[m_tail & m_mask];
+        if (slot.seq.load(std::memory_order_acquire) != m_tail + 1) return false;
+        msg.swap(slot.msg);
+        slot.msg.clear();
+        slot.seq.store(m_tail + m_mask + 1, std::memory_order_release);
+        ++m_tail;
+        return true;
+    }
+};
+
+BCLog::Logger::Logger() {}
+
+BCLog::Logger::~Logger()
+{
+    StopAsyncLogging();
+    if (m_fileout) fclose(m_fileout);
+}
+
 bool BCLog::Logger::OpenDebugLog()
 {
     std::lock_guard<std::mutex> scoped_lock(m_file_mutex);
@@ -213,6 +289,30 @@ void BCLog::Logger::LogPrintStr(const std::string &str)
 {
     std::string strTimestamped = LogTimestampStr(str);
 
+    if (m_async.load(std::memory_order_acquire)) {
+        // Only the message that makes the queue non-empty wakes the writer,
+        // which drains everything queued before it waits again.
+        const bool was_empty = m_pending.fetch_add(1) == 0;
+        if (m_queue->TryPush(std::move(strTimestamped))) {
+            if (was_empty) {
+                // Taking the mutex orders the notification after the writer
+                // has either checked m_pending or started waiting.
+                { std::lock_guard<std::mutex> lock(m_writer_mutex); }
+                m_writer_cond.notify_one();
+            }
+        } else {
+            --m_pending;
+            ++m_dropped_unreported;
+            ++m_dropped_total;
+        }
+        return;
+    }
+
+    WriteStr(strTimestamped);
+}
+
+void BCLog::Logger::WriteStr(const std::string& strTimestamped)
+{
     if (m_print_to_console) {
         // print to console
         fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
@@ -242,6 +342,81 @@ void BCLog::Logger::LogPrintStr(const std::string &str)
     }
 }
 
+void BCLog::Logger::DrainQueue(std::string& batch)
+{
+    // Gather messages into large writes; the debug log file is unbuffered.
+    constexpr size_t MAX_BATCH_SIZE = 1 << 16;
+
+    std::string msg;
+    batch.clear();
+    while (m_queue->TryPop(msg)) {
+        --m_pending;
+        batch += msg;
+        if (batch.size() >= MAX_BATCH_SIZE) {
+            WriteStr(batch);
+            batch.clear();
+        }
+    }
+
+    const uint64_t dropped = m_dropped_unreported.exchange(0);
+    if (dropped > 0) {
+        batch += strprintf("%s%u log messages dropped, the log buffer was full\n",
+            m_log_timestamps ? FormatISO8601DateTime(GetTime()) + ' ' : "", dropped);
+    }
+    if (!batch.empty()) {
+        WriteStr(batch);
+    }
+}
+
+void BCLog::Logger::WriterThread()
+{
+    RenameThread("chaincoin-log");
+    std::string batch;
+    while (true) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(m_writer_mutex);
+            m_writer_cond.wait(lock, [this] { return m_writer_stop || m_pending.load() != 0; });
+            stop = m_writer_stop;
+        }
+        DrainQueue(batch);
+        if (stop) break;
+    }
+}
+
+void BCLog::Logger::StartAsyncLogging(size_t buffer_size)
+{
+    if (m_async) return;
+
+    // A queue left over from an earlier run is reused, as a thread that
+    // raced with StopAsyncLogging() may still be appending to it.
+    if (!m_queue) {
+        size_t capacity = 1;
+        while (capacity < buffer_size) capacity <<= 1;
+        m_queue = MakeUnique<MessageQueue>(capacity);
+    }
+    m_writer_stop = false;
+    m_writer_thread = std::thread(&BCLog::Logger::WriterThread, this);
+    m_async.store(true, std::memory_order_release);
+}
+
+void BCLog::Logger::StopAsyncLogging()
+{
+    if (!m_async) return;
+
+    m_async.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_writer_mutex);
+        m_writer_stop = true;
+    }
+    m_writer_cond.notify_one();
+    m_writer_thread.join();
+
+    // Pick up messages queued while the writer was exiting.
+    std::string batch;
+    DrainQueue(batch);
+}
+
 void BCLog::Logger::ShrinkDebugFile()
 {
     // Amount of debug.log to save at end when shrinking (must fit in memory)
@@ -10,15 +10,20 @@
 #include <tinyformat.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+static const bool DEFAULT_LOGASYNC      = false;
+static const unsigned int DEFAULT_LOGBUFFERSIZE = 8192;
 extern const char * const DEFAULT_DEBUGLOGFILE;
 
 extern bool fLogIPs;
@@ -68,6 +73,25 @@ namespace BCLog {
         std::mutex m_file_mutex;
         std::list<std::string> m_msgs_before_open;
 
+        /**
+         * Bounded queue of messages waiting for the writer thread. Logging
+         * threads only append to it, so they never wait on console or file
+         * I/O. Messages that do not fit are dropped and counted.
+         */
+        class MessageQueue;
+        std::unique_ptr<MessageQueue> m_queue;
+        std::atomic<bool> m_async{false};
+        std::thread m_writer_thread;
+        std::mutex m_writer_mutex;
+        std::condition_variable m_writer_cond;
+        bool m_writer_stop = false;
+        //! Messages pushed or being pushed to m_queue and not yet taken by the writer
+        std::atomic<size_t> m_pending{0};
+
+        /** Messages dropped since the last report in the log, and in total. */
+        std::atomic<uint64_t> m_dropped_unreported{0};
+        std::atomic<uint64_t> m_dropped_total{0};
+
         /**
          * m_started_new_line is a state variable that will suppress printing of
          * the timestamp when multiple calls are made that don't end in a
@@ -80,7 +104,18 @@ namespace BCLog {
 
         std::string LogTimestampStr(const std::string& str);
 
+        /** Write to the console and the debug log file. */
+        void WriteStr(const std::string& str);
+
+        /** Write out everything in m_queue, plus a note of any dropped messages. */
+        void DrainQueue(std::string& batch);
+
+        void WriterThread();
+
     public:
+        Logger();
+        ~Logger();
+
         bool m_print_to_console = false;
         bool m_print_to_file = false;
 
@@ -99,6 +134,19 @@ namespace BCLog {
         bool OpenDebugLog();
         void ShrinkDebugFile();
 
+        /**
+         * Hand messages to a dedicated writer thread, buffering up to
+         * buffer_size of them. When the buffer is full new messages are
+         * dropped rather than blocking the logging thread.
+         */
+        void StartAsyncLogging(size_t buffer_size = DEFAULT_LOGBUFFERSIZE);
+
+        /** Write out buffered messages, stop the writer thread and log synchronously again. */
+        void StopAsyncLogging();
+
+        /** Returns the number of messages dropped because the buffer was full. */
+        uint64_t GetDroppedMessages() const { return m_dropped_total.load(); }
+
         uint32_t GetCategoryMask() const { return m_categories.load(); }
 
         void EnableCategory(LogFlags flag);
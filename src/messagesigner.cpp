@@ -6,9 +6,67 @@
 #include <key_io.h>
 #include <validation.h> // For strMessageMagic
 #include <messagesigner.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <sync.h>
 #include <tinyformat.h>
 #include <util/strencodings.h>
 
+namespace {
+/**
+ * Public keys recovered from compact signatures, keyed by a salted hash of
+ * the signed hash and the signature. A message is often checked against
+ * more than one hash or key (the legacy string format of pings, each
+ * candidate of a verification reply) and every relayed copy recovers the
+ * same key again. Slots are direct mapped: a colliding entry replaces the
+ * older one.
+ */
+class CPubKeyRecoveryCache
+{
+private:
+    static const size_t SLOTS = 1 << 13;
+
+    struct Slot
+    {
+        uint256 key;
+        CPubKey pubkey;
+    };
+
+    uint256 nonce;
+    Mutex cs;
+    std::vector<Slot> vSlots GUARDED_BY(cs);
+
+public:
+    CPubKeyRecoveryCache() : vSlots(SLOTS)
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    bool Recover(const uint256& hash, const std::vector<unsigned char>& vchSig, CPubKey& pubkeyRet)
+    {
+        uint256 key;
+        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(vchSig.data(), vchSig.size()).Finalize(key.begin());
+        const size_t nSlot = key.GetUint64(0) & (SLOTS - 1);
+        {
+            LOCK(cs);
+            if (vSlots[nSlot].key == key) {
+                pubkeyRet = vSlots[nSlot].pubkey;
+                return true;
+            }
+        }
+
+        if (!pubkeyRet.RecoverCompact(hash, vchSig)) return false;
+
+        LOCK(cs);
+        vSlots[nSlot].key = key;
+        vSlots[nSlot].pubkey = pubkeyRet;
+        return true;
+    }
+};
+
+static CPubKeyRecoveryCache pubkeyRecoveryCache;
+} // namespace
+
 bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {
     keyRet = DecodeSecret(strSecret);
@@ -19,22 +77,29 @@ bool CMessageSigner::GetKeysFromSecret(const std::string strSecret, CKey& keyRet
     return true;
 }
 
-bool CMessageSigner::SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey key)
+uint256 CMessageSigner::GetMessageHash(const std::string& strMessage)
+{
+    return GetMessageHash(strMessage.data(), strMessage.size());
+}
+
+uint256 CMessageSigner::GetMessageHash(const char* pchMessage, size_t nLen)
 {
+    // Same as serializing the message as a std::string
     CHashWriter ss(SER_GETHASH, 0);
     ss << strMessageMagic;
-    ss << strMessage;
+    WriteCompactSize(ss, nLen);
+    ss.write(pchMessage, nLen);
+    return ss.GetHash();
+}
 
-    return CHashSigner::SignHash(ss.GetHash(), key, vchSigRet);
+bool CMessageSigner::SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey key)
+{
+    return CHashSigner::SignHash(GetMessageHash(strMessage), key, vchSigRet);
 }
 
 bool CMessageSigner::VerifyMessage(const CPubKey pubkey, const std::vector<unsigned char>& vchSig, const std::string strMessage, std::string& strErrorRet)
 {
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << strMessageMagic;
-    ss << strMessage;
-
-    return CHashSigner::VerifyHash(ss.GetHash(), pubkey, vchSig, strErrorRet);
+    return CHashSigner::VerifyHash(GetMessageHash(strMessage), pubkey, vchSig, strErrorRet);
 }
 
 bool CHashSigner::SignHash(const uint256& hash, const CKey key, std::vector<unsigned char>& vchSigRet)
@@ -42,20 +107,32 @@ bool CHashSigner::SignHash(const uint256& hash, const CKey key, std::vector<unsi
     return key.SignCompact(hash, vchSigRet);
 }
 
+bool CHashSigner::RecoverPubKey(const uint256& hash, const std::vector<unsigned char>& vchSig, CPubKey& pubkeyRet)
+{
+    return pubkeyRecoveryCache.Recover(hash, vchSig, pubkeyRet);
+}
+
 bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
+    if(vchSig.size() == CPubKey::COMPACT_SIGNATURE_SIZE && IsMessageSignatureCached(hash, vchSig, pubkey)) {
+        return true;
+    }
+
     CPubKey pubkeyFromSig;
-    if(!pubkeyFromSig.RecoverCompact(hash, vchSig)) {
+    if(!pubkeyRecoveryCache.Recover(hash, vchSig, pubkeyFromSig)) {
         strErrorRet = "Error recovering public key.";
         return false;
     }
 
-    if(pubkeyFromSig.GetID() != pubkey.GetID()) {
+    // The recovered key is serialized compressed or not like the signing
+    // key, so equal keys have equal IDs without hashing either of them.
+    if(pubkeyFromSig != pubkey) {
         strErrorRet = strprintf("Keys don't match: pubkey=%s, pubkeyFromSig=%s, hash=%s, vchSig=%s",
                     pubkey.GetID().ToString(), pubkeyFromSig.GetID().ToString(), hash.ToString(),
                     EncodeBase64(&vchSig[0], vchSig.size()));
         return false;
     }
 
+    CacheMessageSignature(hash, vchSig, pubkey);
     return true;
 }
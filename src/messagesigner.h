@@ -14,6 +14,9 @@ class CMessageSigner
 public:
     /// Set the private/public key values, returns true if successful
     static bool GetKeysFromSecret(const std::string strSecret, CKey& keyRet, CPubKey& pubkeyRet);
+    /// Hash of the message as signed, with the message magic prepended
+    static uint256 GetMessageHash(const std::string& strMessage);
+    static uint256 GetMessageHash(const char* pchMessage, size_t nLen);
     /// Sign the message, returns true if successful
     static bool SignMessage(const std::string strMessage, std::vector<unsigned char>& vchSigRet, const CKey key);
     /// Verify the message signature, returns true if succcessful
@@ -27,6 +30,8 @@ class CHashSigner
 public:
     /// Sign the hash, returns true if successful
     static bool SignHash(const uint256& hash, const CKey key, std::vector<unsigned char>& vchSigRet);
+    /// Recover the public key the hash was signed with, returns true if successful
+    static bool RecoverPubKey(const uint256& hash, const std::vector<unsigned char>& vchSig, CPubKey& pubkeyRet);
     /// Verify the hash signature, returns true if succcessful
     static bool VerifyHash(const uint256& hash, const CPubKey pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
 };
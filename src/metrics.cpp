@@ -0,0 +1,165 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <metrics.h>
+
+#include <tinyformat.h>
+
+#include <algorithm>
+#include <cassert>
+
+MetricsRegistry& GetMetrics()
+{
+    // Leaked for the same reason as the logger: metrics may be recorded by
+    // threads and destructors that outlive static destruction.
+    static MetricsRegistry* g_metrics{new MetricsRegistry()};
+    return *g_metrics;
+}
+
+/** Format a duration in microseconds as seconds, without trailing zeros. */
+static std::string FormatSeconds(uint64_t micros)
+{
+    std::string str = strprintf("%d.%06d", micros / 1000000, micros % 1000000);
+    str.erase(str.find_last_not_of('0') + 1);
+    if (str.back() == '.') str.pop_back();
+    return str;
+}
+
+static std::string AppendLabel(const std::string& labels, const std::string& label)
+{
+    if (labels.empty()) return "{" + label + "}";
+    return labels.substr(0, labels.size() - 1) + "," + label + "}";
+}
+
+void MetricCounter::Render(const std::string& name, const std::string& labels, std::string& out) const
+{
+    out += strprintf("%s%s %u\n", name, labels, Get());
+}
+
+void MetricGauge::Render(const std::string& name, const std::string& labels, std::string& out) const
+{
+    out += strprintf("%s%s %d\n", name, labels, Get());
+}
+
+const uint64_t* MetricHistogram::Bounds()
+{
+    static const std::vector<uint64_t> bounds = [] {
+        std::vector<uint64_t> result{1};
+        for (uint64_t power = 2; result.size() < NUM_BOUNDS; power *= 2) {
+            result.push_back(power);
+            result.push_back(power + power / 2);
+        }
+        result.resize(NUM_BOUNDS);
+        return result;
+    }();
+    return bounds.data();
+}
+
+void MetricHistogram::Observe(int64_t micros)
+{
+    const uint64_t value = std::max<int64_t>(micros, 0);
+    const uint64_t* bounds = Bounds();
+    const size_t bucket = std::lower_bound(bounds, bounds + NUM_BOUNDS, value) - bounds;
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum_us.fetch_add(value, std::memory_order_relaxed);
+}
+
+void MetricHistogram::Render(const std::string& name, const std::string& labels, std::string& out) const
+{
+    const uint64_t* bounds = Bounds();
+    uint64_t cumulative = 0;
+    for (int i = 0; i < NUM_BOUNDS; i++) {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+        out += strprintf("%s_bucket%s %u\n", name, AppendLabel(labels, "le=\"" + FormatSeconds(bounds[i]) + "\""), cumulative);
+    }
+    cumulative += m_buckets[NUM_BOUNDS].load(std::memory_order_relaxed);
+    out += strprintf("%s_bucket%s %u\n", name, AppendLabel(labels, "le=\"+Inf\""), cumulative);
+    out += strprintf("%s_sum%s %s\n", name, labels, FormatSeconds(GetSumMicros()));
+    out += strprintf("%s_count%s %u\n", name, labels, cumulative);
+}
+
+template <typename T>
+T& MetricsRegistry::Get(const char* type, const std::string& name, const std::string& help, const std::string& label_name, const std::string& label_value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Family& family = m_families[name];
+    if (family.type.empty()) {
+        family.type = type;
+        family.help = help;
+        family.label_name = label_name;
+    }
+    // A name must always be used with the same type and label.
+    assert(family.type == type && family.label_name == label_name);
+
+    std::unique_ptr<Metric>& metric = family.metrics[label_value];
+    if (!metric) metric.reset(new T());
+    return static_cast<T&>(*metric);
+}
+
+MetricCounter& MetricsRegistry::Counter(const std::string& name, const std::string& help, const std::string& label_name, const std::string& label_value)
+{
+    return Get<MetricCounter>("counter", name, help, label_name, label_value);
+}
+
+MetricGauge& MetricsRegistry::Gauge(const std::string& name, const std::string& help, const std::string& label_name, const std::string& label_value)
+{
+    return Get<MetricGauge>("gauge", name, help, label_name, label_value);
+}
+
+MetricHistogram& MetricsRegistry::Histogram(const std::string& name, const std::string& help, const std::string& label_name, const std::string& label_value)
+{
+    return Get<MetricHistogram>("histogram", name, help, label_name, label_value);
+}
+
+void MetricsRegistry::AddCollector(std::function<void()> collector)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_collectors.push_back(std::move(collector));
+}
+
+static std::string EscapeLabelValue(const std::string& value)
+{
+    std::string result;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+std::string MetricsRegistry::Render()
+{
+    // Collectors may register metrics, so they run without the lock held.
+    std::vector<std::function<void()>> collectors;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        collectors = m_collectors;
+    }
+    for (const auto& collector : collectors) {
+        collector();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string out;
+    for (const auto& entry : m_families) {
+        const Family& family = entry.second;
+        out += strprintf("# HELP %s %s\n", entry.first, family.help);
+        out += strprintf("# TYPE %s %s\n", entry.first, family.type);
+        for (const auto& metric : family.metrics) {
+            std::string labels;
+            if (!family.label_name.empty()) {
+                labels = strprintf("{%s=\"%s\"}", family.label_name, EscapeLabelValue(metric.first));
+            }
+            metric.second->Render(entry.first, labels, out);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_METRICS_H
+#define BITCOIN_METRICS_H
+
+#include <util/time.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const bool DEFAULT_METRICS = false;
+
+/** A metric of the registry, rendered in the Prometheus text exposition format. */
+class Metric
+{
+public:
+    virtual ~Metric() {}
+
+    /** Append the samples of the metric, given its name and label selector (e.g. {command="inv"}). */
+    virtual void Render(const std::string& name, const std::string& labels, std::string& out) const = 0;
+};
+
+/** A count that only goes up. */
+class MetricCounter final : public Metric
+{
+private:
+    std::atomic<uint64_t> m_value{0};
+
+public:
+    void Inc(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    /** Take the value of a total counted elsewhere, which must only go up. */
+    void Set(uint64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+    void Render(const std::string& name, const std::string& labels, std::string& out) const override;
+};
+
+/** A value that can go up and down. */
+class MetricGauge final : public Metric
+{
+private:
+    std::atomic<int64_t> m_value{0};
+
+public:
+    void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+    void Render(const std::string& name, const std::string& labels, std::string& out) const override;
+};
+
+/**
+ * Distribution of durations in microseconds. Like an HDR histogram, bucket
+ * widths grow with the value: there are two buckets per power of two, so any
+ * recorded duration is known to within 50% whatever its magnitude, and
+ * recording is a short search and two relaxed atomic increments.
+ */
+class MetricHistogram final : public Metric
+{
+public:
+    //! Bucket upper bounds: 1, 2, 3, 4, 6, 8, 12, 16, ... microseconds, up to 2^32 (about 72 minutes)
+    static constexpr int NUM_BOUNDS = 64;
+    static const uint64_t* Bounds();
+
+private:
+    std::atomic<uint64_t> m_buckets[NUM_BOUNDS + 1] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum_us{0};
+
+public:
+    void Observe(int64_t micros);
+
+    uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t GetSumMicros() const { return m_sum_us.load(std::memory_order_relaxed); }
+
+    void Render(const std::string& name, const std::string& labels, std::string& out) const override;
+};
+
+/** Observes the time spent in its scope into a histogram. */
+class MetricTimer
+{
+private:
+    MetricHistogram& m_histogram;
+    const int64_t m_start;
+
+public:
+    explicit MetricTimer(MetricHistogram& histogram) : m_histogram(histogram), m_start(GetTimeMicros()) {}
+    ~MetricTimer() { m_histogram.Observe(GetTimeMicros() - m_start); }
+};
+
+/**
+ * Registry of the node's metrics. A metric is identified by a family name and
+ * an optional value of the family's single label; asking for it again returns
+ * the same object, so hot paths can keep a reference.
+ */
+class MetricsRegistry
+{
+private:
+    struct Family
+    {
+        std::string type;
+        std::string help;
+        std::string label_name;
+        std::map<std::string, std::unique_ptr<Metric>> metrics;
+    };
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Family> m_families;
+    std::vector<std::function<void()>> m_collectors;
+
+    template <typename T>
+    T& Get(const char* type, const std::string& name, const std::string& help, const std::string& label_name, const std::string& label_value);
+
+public:
+    MetricCounter& Counter(const std::string& name, const std::string& help, const std::string& label_name = "", const std::string& label_value = "");
+    MetricGauge& Gauge(const std::string& name, const std::string& help, const std::string& label_name = "", const std::string& label_value = "");
+    MetricHistogram& Histogram(const std::string& name, const std::string& help, const std::string& label_name = "", const std::string& label_value = "");
+
+    /** Add a function run before rendering, to update gauges that are sampled rather than tracked. */
+    void AddCollector(std::function<void()> collector);
+
+    /** Render every metric in the Prometheus text exposition format. */
+    std::string Render();
+};
+
+/** The global metrics registry. Like the logger, it is never destroyed. */
+MetricsRegistry& GetMetrics();
+
+#endif // BITCOIN_METRICS_H
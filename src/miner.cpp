@@ -14,6 +14,7 @@
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <hash.h>
+#include <metrics.h>
 #include <modules/masternode/masternode_payments.h>
 #include <net.h>
 #include <policy/feerate.h>
@@ -88,6 +89,9 @@ void BlockAssembler::resetBlock()
     nFees = 0;
 }
 
+static MetricHistogram& g_create_block_time = GetMetrics().Histogram("chaincoin_block_template_seconds", "Time spent assembling block templates", "method", "create");
+static MetricHistogram& g_update_block_time = GetMetrics().Histogram("chaincoin_block_template_seconds", "Time spent assembling block templates", "method", "update");
+
 Optional<int64_t> BlockAssembler::m_last_block_num_txs{nullopt};
 Optional<int64_t> BlockAssembler::m_last_block_weight{nullopt};
 
@@ -120,6 +124,116 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
         pblock->nVersion = gArgs.GetArg("-blockversion", pblock->nVersion);
 
     pblock->nTime = GetAdjustedTime();
+    InitBlockContext(pindexPrev);
+
+    int nPackagesSelected = 0;
+    int nDescendantsUpdated = 0;
+    addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+
+    int64_t nTime1 = GetTimeMicros();
+
+    CValidationState state;
+    if (!FinalizeBlock(state, pindexPrev, scriptPubKeyIn, true)) {
+        throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
+    }
+
+    int64_t nTime2 = GetTimeMicros();
+
+    g_create_block_time.Observe(nTime2 - nTimeStart);
+    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+
+    return std::move(pblocktemplate);
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::UpdateBlockTemplate(const CBlockTemplate& tmpl, const std::vector<CTransactionRef>& vAdded, const CScript& scriptPubKeyIn)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    LOCK2(cs_main, mempool.cs);
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    assert(pindexPrev != nullptr);
+    if (tmpl.block.hashPrevBlock != pindexPrev->GetBlockHash()) {
+        return nullptr;
+    }
+
+    resetBlock();
+    pblocktemplate.reset(new CBlockTemplate(tmpl));
+    pblock = &pblocktemplate->block; // pointer for convenience
+    nHeight = pindexPrev->nHeight + 1;
+    InitBlockContext(pindexPrev);
+
+    // Restore the selection state of the template. Every transaction it
+    // contains must still be in the mempool, otherwise it may have been
+    // replaced or conflicted and the template has to be rebuilt.
+    for (size_t i = 1; i < pblock->vtx.size(); ++i) {
+        boost::optional<CTxMemPool::txiter> it = mempool.GetIter(pblock->vtx[i]->GetHash());
+        if (!it) {
+            return nullptr;
+        }
+        nBlockWeight += (*it)->GetTxWeight();
+        nBlockSigOpsCost += pblocktemplate->vTxSigOpsCost[i];
+        nFees += pblocktemplate->vTxFees[i];
+        ++nBlockTx;
+        inBlock.insert(*it);
+    }
+
+    // Append new transactions whose in-mempool parents are all part of the
+    // template already, in the order they entered the mempool.
+    int nAdded = 0;
+    for (const CTransactionRef& tx : vAdded) {
+        boost::optional<CTxMemPool::txiter> it = mempool.GetIter(tx->GetHash());
+        if (!it || inBlock.count(*it)) {
+            continue;
+        }
+        const CTxMemPool::txiter iter = *it;
+        bool fParentsIncluded = true;
+        for (CTxMemPool::txiter parent : mempool.GetMemPoolParents(iter)) {
+            if (!inBlock.count(parent)) {
+                fParentsIncluded = false;
+                break;
+            }
+        }
+        if (!fParentsIncluded) {
+            continue;
+        }
+        if (iter->GetModifiedFee() < blockMinFeeRate.GetFee(iter->GetTxSize())) {
+            continue;
+        }
+        if (!TestPackage(iter->GetTxSize(), iter->GetSigOpCost()) || !TestPackageTransactions({iter})) {
+            continue;
+        }
+        // Check the appended transaction on its own, so that one failing
+        // transaction is left out instead of failing the whole template.
+        CValidationState state;
+        if (!TestTransactionValidity(state, chainparams, iter->GetTx(), pindexPrev)) {
+            continue;
+        }
+        AddToBlock(iter);
+        ++nAdded;
+    }
+
+    int64_t nTime1 = GetTimeMicros();
+
+    pblock->vtx[0] = MakeTransactionRef();
+    pblocktemplate->vchCoinbaseCommitment.clear();
+    // The whole block, payments included, is tested again; the scripts
+    // checked above and when the template was built are cache hits.
+    CValidationState state;
+    if (!FinalizeBlock(state, pindexPrev, scriptPubKeyIn, false)) {
+        LogPrintf("%s: TestBlockValidity failed, rebuilding the template: %s\n", __func__, FormatStateMessage(state));
+        return nullptr;
+    }
+
+    int64_t nTime2 = GetTimeMicros();
+
+    g_update_block_time.Observe(nTime2 - nTimeStart);
+    LogPrint(BCLog::BENCH, "UpdateBlockTemplate() appended: %.2fms (%d txs), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nAdded, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
+
+    return std::move(pblocktemplate);
+}
+
+void BlockAssembler::InitBlockContext(const CBlockIndex* pindexPrev)
+{
     const int64_t nMedianTimePast = pindexPrev->GetMedianTimePast();
 
     nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
@@ -136,13 +250,10 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     // TODO: replace this with a call to main to assess validity of a mempool
     // transaction (which in most cases can be a no-op).
     fIncludeWitness = IsWitnessEnabled(pindexPrev, chainparams.GetConsensus());
+}
 
-    int nPackagesSelected = 0;
-    int nDescendantsUpdated = 0;
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated);
-
-    int64_t nTime1 = GetTimeMicros();
-
+bool BlockAssembler::FinalizeBlock(CValidationState& state, CBlockIndex* pindexPrev, const CScript& scriptPubKeyIn, bool fFillPayments)
+{
     m_last_block_num_txs = nBlockTx;
     m_last_block_weight = nBlockWeight;
 
@@ -155,7 +266,13 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
     coinbaseTx.vout[0].nValue = blockReward;
     coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
-    FillBlockPayments(coinbaseTx, nHeight, blockReward, pblock->txoutMasternode, pblock->voutSuperblock);
+    if (fFillPayments) {
+        FillBlockPayments(coinbaseTx, nHeight, blockReward, pblock->txoutMasternode, pblock->voutSuperblock);
+    } else {
+        // The payees for this height were selected when the template was
+        // first built; only the reward dependent amounts change.
+        ApplyBlockPayments(coinbaseTx, nHeight, blockReward, pblock->txoutMasternode, pblock->voutSuperblock);
+    }
     pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
     pblocktemplate->vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, chainparams.GetConsensus());
     pblocktemplate->vTxFees[0] = -nFees;
@@ -169,15 +286,9 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblock->nNonce         = 0;
     pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
 
-    CValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
-        throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, FormatStateMessage(state)));
-    }
-    int64_t nTime2 = GetTimeMicros();
-
-    LogPrint(BCLog::BENCH, "CreateNewBlock() packages: %.2fms (%d packages, %d updated descendants), validity: %.2fms (total %.2fms)\n", 0.001 * (nTime1 - nTimeStart), nPackagesSelected, nDescendantsUpdated, 0.001 * (nTime2 - nTime1), 0.001 * (nTime2 - nTimeStart));
-
-    return std::move(pblocktemplate);
+    // Scripts of transactions accepted to the mempool were also run under the
+    // next block's flags there, so their checks are script execution cache hits.
+    return TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false);
 }
 
 void BlockAssembler::onlyUnconfirmed(CTxMemPool::setEntries& testSet)
@@ -430,6 +541,74 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
+BlockTemplateCache::BlockTemplateCache(CTxMemPool& pool) : m_pool(pool), m_time_built(0), m_invalidated(false)
+{
+    m_conn_added = m_pool.NotifyEntryAdded.connect(std::bind(&BlockTemplateCache::TransactionAdded, this, std::placeholders::_1));
+    m_conn_removed = m_pool.NotifyEntryRemoved.connect(std::bind(&BlockTemplateCache::TransactionRemoved, this, std::placeholders::_1, std::placeholders::_2));
+}
+
+void BlockTemplateCache::TransactionAdded(CTransactionRef tx)
+{
+    LOCK(cs);
+    if (!m_template) return;
+    if (GetTime() - m_time_built > BLOCK_TEMPLATE_REBUILD_INTERVAL) {
+        // The next call rebuilds from scratch anyway
+        m_template.reset();
+        m_added.clear();
+        m_template_txids.clear();
+        return;
+    }
+    m_added.push_back(std::move(tx));
+}
+
+void BlockTemplateCache::TransactionRemoved(CTransactionRef tx, MemPoolRemovalReason reason)
+{
+    LOCK(cs);
+    // Transactions confirmed in a block go along with a new tip, which
+    // already forces a rebuild.
+    if (reason != MemPoolRemovalReason::BLOCK && m_template_txids.count(tx->GetHash())) {
+        m_invalidated = true;
+    }
+}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateCache::Get(const CChainParams& params, const CScript& scriptPubKeyIn)
+{
+    // The mempool notifies us while holding its lock, so take it first.
+    LOCK2(cs_main, m_pool.cs);
+    LOCK(cs);
+
+    const bool fSameTip = m_template && m_template->block.hashPrevBlock == chainActive.Tip()->GetBlockHash();
+    const bool fRebuild = !fSameTip || m_invalidated || m_script != scriptPubKeyIn ||
+                          (!m_added.empty() && GetTime() - m_time_built > BLOCK_TEMPLATE_REBUILD_INTERVAL);
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+    if (!fRebuild && !m_added.empty()) {
+        pblocktemplate = BlockAssembler(params).UpdateBlockTemplate(*m_template, m_added, scriptPubKeyIn);
+    } else if (!fRebuild) {
+        pblocktemplate.reset(new CBlockTemplate(*m_template));
+    }
+
+    if (!pblocktemplate) {
+        pblocktemplate = BlockAssembler(params).CreateNewBlock(scriptPubKeyIn);
+        if (!pblocktemplate) {
+            m_template.reset();
+            return nullptr;
+        }
+        m_time_built = GetTime();
+    }
+
+    m_added.clear();
+    m_invalidated = false;
+    m_script = scriptPubKeyIn;
+    m_template_txids.clear();
+    for (const CTransactionRef& tx : pblocktemplate->block.vtx) {
+        m_template_txids.insert(tx->GetHash());
+    }
+    m_template.reset(new CBlockTemplate(*pblocktemplate));
+
+    return pblocktemplate;
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
     // Update nExtraNonce
@@ -12,6 +12,7 @@
 #include <validation.h>
 
 #include <memory>
+#include <set>
 #include <stdint.h>
 
 #include <boost/multi_index_container.hpp>
@@ -160,6 +161,10 @@ public:
 
     /** Construct a new block template with coinbase to scriptPubKeyIn */
     std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
+    /** Extend a template built by CreateNewBlock on the current tip with the
+     *  given transactions added to the mempool since, reusing its payees.
+     *  Returns nullptr if the template must be rebuilt from scratch. */
+    std::unique_ptr<CBlockTemplate> UpdateBlockTemplate(const CBlockTemplate& tmpl, const std::vector<CTransactionRef>& vAdded, const CScript& scriptPubKeyIn);
 
     static Optional<int64_t> m_last_block_num_txs;
     static Optional<int64_t> m_last_block_weight;
@@ -170,6 +175,10 @@ private:
     void resetBlock();
     /** Add a tx to the block */
     void AddToBlock(CTxMemPool::txiter iter);
+    /** Set the locktime cutoff and witness inclusion for a block on top of pindexPrev */
+    void InitBlockContext(const CBlockIndex* pindexPrev);
+    /** Create the coinbase, fill in the header and test the whole block's validity */
+    bool FinalizeBlock(CValidationState& state, CBlockIndex* pindexPrev, const CScript& scriptPubKeyIn, bool fFillPayments);
 
     // Methods for how to add transactions to a block.
     /** Add transactions based on feerate including unconfirmed ancestors
@@ -198,6 +207,48 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 };
 
+/** Rebuild the cached block template from scratch at least this often (in seconds) */
+static const int64_t BLOCK_TEMPLATE_REBUILD_INTERVAL = 30;
+
+/**
+ * Keeps the block template served by getblocktemplate up to date between
+ * calls. Transactions entering the mempool are appended to the cached
+ * template when their in-mempool parents are already part of it, so an
+ * update only costs the checks of the new transactions. A new tip, the
+ * removal of a transaction included in the template or
+ * BLOCK_TEMPLATE_REBUILD_INTERVAL passing with pending changes trigger a full
+ * CreateNewBlock. A template older than that is dropped as soon as the
+ * mempool changes, so pending changes never pile up between calls.
+ */
+class BlockTemplateCache
+{
+public:
+    explicit BlockTemplateCache(CTxMemPool& pool);
+
+    /** Return a copy of the template for the current tip */
+    std::unique_ptr<CBlockTemplate> Get(const CChainParams& params, const CScript& scriptPubKeyIn);
+
+private:
+    void TransactionAdded(CTransactionRef tx);
+    void TransactionRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
+
+    CTxMemPool& m_pool;
+
+    CCriticalSection cs;
+    std::unique_ptr<CBlockTemplate> m_template GUARDED_BY(cs);
+    CScript m_script GUARDED_BY(cs);
+    int64_t m_time_built GUARDED_BY(cs);
+    //! Transactions added to the mempool since the template was last updated
+    std::vector<CTransactionRef> m_added GUARDED_BY(cs);
+    //! Transactions of the cached template
+    std::set<uint256> m_template_txids GUARDED_BY(cs);
+    //! Set when a transaction of the template left the mempool
+    bool m_invalidated GUARDED_BY(cs);
+
+    boost::signals2::scoped_connection m_conn_added;
+    boost::signals2::scoped_connection m_conn_removed;
+};
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
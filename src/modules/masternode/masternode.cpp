@@ -676,6 +676,35 @@ uint256 CMasternodePing::GetSignatureHash() const
     return GetHash();
 }
 
+/** Write hash.ToString() into strHex, without allocating a string */
+static void FormatHash(const uint256& hash, char (&strHex)[65])
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) {
+        const unsigned char c = hash.begin()[31 - i];
+        strHex[2 * i] = hexdigits[c >> 4];
+        strHex[2 * i + 1] = hexdigits[c & 15];
+    }
+    strHex[64] = '\0';
+}
+
+uint256 CMasternodePing::GetLegacySignatureHash() const
+{
+    // The message is CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() +
+    // std::to_string(sigTime), formatted on the stack
+    char strOutpointHash[65];
+    char strBlockHash[65];
+    FormatHash(masternodeOutpoint.hash, strOutpointHash);
+    FormatHash(blockHash, strBlockHash);
+
+    char strMessage[192];
+    const int nLen = snprintf(strMessage, sizeof(strMessage), "CTxIn(COutPoint(%s, %u), %s)%s%lld",
+                              strOutpointHash, masternodeOutpoint.n, masternodeOutpoint.IsNull() ? "coinbase " : "scriptSig=",
+                              strBlockHash, (long long)sigTime);
+    assert(nLen > 0 && (size_t)nLen < sizeof(strMessage));
+    return CMessageSigner::GetMessageHash(strMessage, nLen);
+}
+
 CMasternodePing::CMasternodePing(const COutPoint& outpoint)
 {
     LOCK(cs_main);
@@ -716,10 +745,7 @@ bool CMasternodePing::CheckSignature(const CPubKey& pubKeyMasternode, int &nDos)
     uint256 hash = GetSignatureHash();
 
     if (!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchSig, strError)) {
-        std::string strMessage = CTxIn(masternodeOutpoint).ToString() + blockHash.ToString() +
-                    std::to_string(sigTime);
-
-        if (!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)) {
+        if (!CHashSigner::VerifyHash(GetLegacySignatureHash(), pubKeyMasternode, vchSig, strError)) {
             LogPrintf("CMasternodePing::CheckSignature -- Got bad Masternode ping signature, masternode=%s, error: %s\n", masternodeOutpoint.ToStringShort(), strError);
             nDos = 33;
             return false;
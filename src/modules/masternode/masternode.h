@@ -65,6 +65,8 @@ public:
 
     uint256 GetHash() const;
     uint256 GetSignatureHash() const;
+    /// Hash of the string message pings of old daemons were signed as
+    uint256 GetLegacySignatureHash() const;
 
     bool IsExpired() const { return GetAdjustedTime() - sigTime > MASTERNODE_NEW_START_REQUIRED_SECONDS; }
 
@@ -28,7 +28,7 @@
 /** Masternode manager */
 CMasternodeMan mnodeman;
 
-const std::string CMasternodeMan::SERIALIZATION_VERSION_STRING = "CMasternodeMan-Version-7";
+const std::string CMasternodeMan::SERIALIZATION_VERSION_STRING = "CMasternodeMan-Version-8";
 const int CMasternodeMan::LAST_PAID_SCAN_BLOCKS = 100;
 
 struct CompareLastPaidBlock
@@ -49,19 +49,12 @@ struct CompareScoreMN
     }
 };
 
-struct CompareByAddr
-
-{
-    bool operator()(const CMasternode* t1,
-                    const CMasternode* t2) const
-    {
-        return t1->addr < t2->addr;
-    }
-};
 
 CMasternodeMan::CMasternodeMan():
     cs(),
     mapMasternodes(),
+    nJournalStartHeight(-1),
+    nLastSyncedHeight(0),
     mAskedUsForMasternodeList(),
     mWeAskedForMasternodeList(),
     mWeAskedForMasternodeListEntry(),
@@ -86,6 +79,8 @@ bool CMasternodeMan::Add(CMasternode &mn)
     LogPrint(BCLog::MNODE, "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     uiInterface.NotifyMasternodeChanged(mn.outpoint, CT_NEW);
     mapMasternodes[mn.outpoint] = mn;
+    IndexMasternode(mn);
+    ScheduleCheck(mn, 0);
     fMasternodesAdded = true;
     return true;
 }
@@ -143,7 +138,94 @@ void CMasternodeMan::Check()
         // NOTE: internally it checks only every MASTERNODE_CHECK_SECONDS seconds
         // since the last time, so expect some MNs to skip this
         mnpair.second.Check();
+        JournalMasternode(mnpair.second);
+        ScheduleCheck(mnpair.second);
+    }
+}
+
+void CMasternodeMan::CheckDue()
+{
+    LOCK2(cs_main, cs);
+
+    const int64_t nNow = GetAdjustedTime();
+    while (!setCheckQueue.empty() && setCheckQueue.begin()->first <= nNow) {
+        const COutPoint outpoint = setCheckQueue.begin()->second;
+        CMasternode* pmn = Find(outpoint);
+        if (!pmn) {
+            UnscheduleCheck(outpoint);
+            continue;
+        }
+        pmn->Check(true);
+        JournalMasternode(*pmn);
+        ScheduleCheck(*pmn);
+    }
+}
+
+void CMasternodeMan::ScheduleCheck(const CMasternode& mn, int64_t nTime)
+{
+    AssertLockHeld(cs);
+
+    UnscheduleCheck(mn.outpoint);
+
+    if (nTime < 0) {
+        // the state only moves with time when the last ping gets older than one of these
+        const int64_t nNow = GetAdjustedTime();
+        for (int nSeconds : {MASTERNODE_MIN_MNP_SECONDS, MASTERNODE_SENTINEL_PING_MAX_SECONDS,
+                             MASTERNODE_EXPIRATION_SECONDS, MASTERNODE_NEW_START_REQUIRED_SECONDS}) {
+            if (mn.lastPing.sigTime + nSeconds > nNow) {
+                nTime = mn.lastPing.sigTime + nSeconds;
+                break;
+            }
+        }
+        // nothing left to expire, only a new ping or the periodic full check can change it
+        if (nTime < 0) return;
+    }
+
+    setCheckQueue.emplace(nTime, mn.outpoint);
+    mapNextCheckTime[mn.outpoint] = nTime;
+}
+
+void CMasternodeMan::UnscheduleCheck(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs);
+
+    auto it = mapNextCheckTime.find(outpoint);
+    if (it == mapNextCheckTime.end()) return;
+    setCheckQueue.erase(std::make_pair(it->second, outpoint));
+    mapNextCheckTime.erase(it);
+}
+
+void CMasternodeMan::JournalMasternode(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+
+    // nothing before the list is synced is worth replaying to peers
+    if (nJournalStartHeight < 0) return;
+
+    const std::pair<int, int> state = std::make_pair(mn.nActiveState, mn.nProtocolVersion);
+    auto it = mapJournaledStates.find(mn.outpoint);
+    if (it != mapJournaledStates.end() && it->second == state) return;
+    mapJournaledStates[mn.outpoint] = state;
+
+    journal.vHeight.push_back(nCachedBlockHeight);
+    journal.vOutpoint.push_back(mn.outpoint);
+    journal.vActiveState.push_back(mn.nActiveState);
+    journal.vProtocolVersion.push_back(mn.nProtocolVersion);
+}
+
+void CMasternodeMan::PruneJournal()
+{
+    AssertLockHeld(cs);
+
+    const int nMinHeight = nCachedBlockHeight - JOURNAL_DEPTH_BLOCKS;
+    while (!journal.vHeight.empty() && (journal.vHeight.front() < nMinHeight || journal.vHeight.size() > MAX_JOURNAL_ROWS)) {
+        nJournalStartHeight = std::max(nJournalStartHeight, journal.vHeight.front());
+        journal.vHeight.pop_front();
+        journal.vOutpoint.pop_front();
+        journal.vActiveState.pop_front();
+        journal.vProtocolVersion.pop_front();
     }
+    nJournalStartHeight = std::max(nJournalStartHeight, nMinHeight - 1);
 }
 
 void CMasternodeMan::CheckAndRemove(CConnman* connman)
@@ -178,6 +260,9 @@ void CMasternodeMan::CheckAndRemove(CConnman* connman)
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
                 uiInterface.NotifyMasternodeChanged(it->first, CT_DELETED);
+                UnindexMasternode(it->second);
+                mapJournaledStates.erase(it->first);
+                UnscheduleCheck(it->first);
                 mapMasternodes.erase(it++);
                 fMasternodesRemoved = true;
             } else {
@@ -335,6 +420,16 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    mapOutpointsByAddr.clear();
+    mapOutpointsByPubKey.clear();
+    mapOutpointsByPayee.clear();
+    mapCachedScores.clear();
+    journal = StateJournal();
+    nJournalStartHeight = -1;
+    mapJournaledStates.clear();
+    setCheckQueue.clear();
+    mapNextCheckTime.clear();
+    nLastSyncedHeight = 0;
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -402,7 +497,12 @@ void CMasternodeMan::DsegUpdate(CNode* pnode, CConnman* connman)
         }
     }
 
-    connman->PushMessage(pnode, msgMaker.Make(NetMsgType::DSEG, COutPoint()));
+    if (pnode->fSupportsDsegDelta && nLastSyncedHeight > 0 && !mapMasternodes.empty()) {
+        // our list was complete not long ago, only ask for what changed since
+        connman->PushMessage(pnode, msgMaker.Make(NetMsgType::DSEGDELTA, nLastSyncedHeight));
+    } else {
+        connman->PushMessage(pnode, msgMaker.Make(NetMsgType::DSEG, COutPoint()));
+    }
 
     int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
     mWeAskedForMasternodeList[addrSquashed] = askAgain;
@@ -417,6 +517,54 @@ CMasternode* CMasternodeMan::Find(const COutPoint &outpoint)
     return it == mapMasternodes.end() ? nullptr : &(it->second);
 }
 
+static CScript GetCollateralScript(const CMasternode& mn)
+{
+    return GetScriptForDestination(mn.pubKeyCollateralAddress.GetID());
+}
+
+void CMasternodeMan::IndexMasternode(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    mapCachedScores.clear();
+    mapOutpointsByAddr[mn.addr].insert(mn.outpoint);
+    mapOutpointsByPubKey[mn.pubKeyMasternode].insert(mn.outpoint);
+    mapOutpointsByPayee[GetCollateralScript(mn)].insert(mn.outpoint);
+}
+
+template <typename Key>
+static void EraseIndexEntry(std::map<Key, std::set<COutPoint> >& index, const Key& key, const COutPoint& outpoint)
+{
+    auto it = index.find(key);
+    if (it == index.end()) return;
+    it->second.erase(outpoint);
+    if (it->second.empty()) index.erase(it);
+}
+
+void CMasternodeMan::UnindexMasternode(const CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    mapCachedScores.clear();
+    EraseIndexEntry<CService>(mapOutpointsByAddr, mn.addr, mn.outpoint);
+    EraseIndexEntry(mapOutpointsByPubKey, mn.pubKeyMasternode, mn.outpoint);
+    EraseIndexEntry(mapOutpointsByPayee, GetCollateralScript(mn), mn.outpoint);
+}
+
+void CMasternodeMan::RebuildIndexes()
+{
+    LOCK(cs);
+    mapOutpointsByAddr.clear();
+    mapOutpointsByPubKey.clear();
+    mapOutpointsByPayee.clear();
+    setCheckQueue.clear();
+    mapNextCheckTime.clear();
+    mapCachedScores.clear();
+    for (const auto& mnpair : mapMasternodes) {
+        IndexMasternode(mnpair.second);
+        // loaded entries are checked on the first tick
+        ScheduleCheck(mnpair.second, 0);
+    }
+}
+
 bool CMasternodeMan::Get(const COutPoint& outpoint, CMasternode& masternodeRet)
 {
     // Theses mutexes are recursive so double locking by the same thread is safe.
@@ -444,26 +592,22 @@ bool CMasternodeMan::GetMasternodeInfo(const COutPoint& outpoint, masternode_inf
 bool CMasternodeMan::GetMasternodeInfo(const CPubKey& pubKeyMasternode, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    auto it = mapOutpointsByPubKey.find(pubKeyMasternode);
+    if (it == mapOutpointsByPubKey.end()) {
+        return false;
     }
-    return false;
+    // the first outpoint is the one a scan of mapMasternodes would find
+    return GetMasternodeInfo(*it->second.begin(), mnInfoRet);
 }
 
 bool CMasternodeMan::GetMasternodeInfo(const CScript& payee, masternode_info_t& mnInfoRet)
 {
     LOCK(cs);
-    for (const auto& mnpair : mapMasternodes) {
-        CScript scriptCollateralAddress = GetScriptForDestination(mnpair.second.pubKeyCollateralAddress.GetID());
-        if (scriptCollateralAddress == payee) {
-            mnInfoRet = mnpair.second.GetInfo();
-            return true;
-        }
+    auto it = mapOutpointsByPayee.find(payee);
+    if (it == mapOutpointsByPayee.end()) {
+        return false;
     }
-    return false;
+    return GetMasternodeInfo(*it->second.begin(), mnInfoRet);
 }
 
 bool CMasternodeMan::Has(const COutPoint& outpoint)
@@ -612,27 +756,27 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
     return masternode_info_t();
 }
 
-bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeMan::score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol)
+const CMasternodeMan::score_pair_vec_t& CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, int nMinProtocol)
 {
-    vecMasternodeScoresRet.clear();
+    AssertLockHeld(cs);
 
-    if (!masternodeSync.IsMasternodeListSynced())
-        return false;
+    const auto key = std::make_pair(nBlockHash, nMinProtocol);
+    auto it = mapCachedScores.find(key);
+    if (it != mapCachedScores.end()) return it->second;
 
-    AssertLockHeld(cs);
+    if (mapCachedScores.size() >= MAX_CACHED_SCORES) mapCachedScores.clear();
 
-    if (mapMasternodes.empty())
-        return false;
+    score_pair_vec_t& vecMasternodeScores = mapCachedScores[key];
 
     // calculate scores
     for (const auto& mnpair : mapMasternodes) {
         if (mnpair.second.nProtocolVersion >= nMinProtocol) {
-            vecMasternodeScoresRet.push_back(std::make_pair(mnpair.second.CalculateScore(nBlockHash), &mnpair.second));
+            vecMasternodeScores.push_back(std::make_pair(mnpair.second.CalculateScore(nBlockHash), &mnpair.second));
         }
     }
 
-    std::sort(vecMasternodeScoresRet.rbegin(), vecMasternodeScoresRet.rend(), CompareScoreMN());
-    return !vecMasternodeScoresRet.empty();
+    std::sort(vecMasternodeScores.rbegin(), vecMasternodeScores.rend(), CompareScoreMN());
+    return vecMasternodeScores;
 }
 
 bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet, int nBlockHeight, int nMinProtocol)
@@ -651,8 +795,8 @@ bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(blockHash, vecMasternodeScores, nMinProtocol))
+    const score_pair_vec_t& vecMasternodeScores = GetMasternodeScores(blockHash, nMinProtocol);
+    if (vecMasternodeScores.empty())
         return false;
 
     int nRank = 0;
@@ -683,8 +827,8 @@ bool CMasternodeMan::GetMasternodeRanks(CMasternodeMan::rank_pair_vec_t& vecMast
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(blockHash, vecMasternodeScores, nMinProtocol))
+    const score_pair_vec_t& vecMasternodeScores = GetMasternodeScores(blockHash, nMinProtocol);
+    if (vecMasternodeScores.empty())
         return false;
 
     int nRank = 0;
@@ -855,7 +999,11 @@ void CMasternodeMan::ProcessModuleMessage(CNode* pfrom, const std::string& strCo
         if (pmn && pmn->IsNewStartRequired()) return;
 
         int nDos = 0;
-        if (mnp.CheckAndUpdate(pmn, false, nDos, connman)) return;
+        if (mnp.CheckAndUpdate(pmn, false, nDos, connman)) {
+            // the new ping pushes the expiry deadlines back
+            ScheduleCheck(*pmn);
+            return;
+        }
 
         if (nDos > 0) {
             // if anything significant failed, mark that node
@@ -887,6 +1035,17 @@ void CMasternodeMan::ProcessModuleMessage(CNode* pfrom, const std::string& strCo
             SyncSingle(pfrom, masternodeOutpoint);
         }
 
+    } else if (strCommand == NetMsgType::DSEGDELTA) { //Get Masternode list changes since a block height
+        if (!masternodeSync.IsSynced()) return;
+
+        int nHeight;
+
+        vRecv >> nHeight;
+
+        LogPrint(BCLog::MNODE, "DSEGDELTA -- Masternode list changes since height %d\n", nHeight);
+
+        SyncDelta(pfrom, nHeight, connman);
+
     } else if (strCommand == NetMsgType::MNVERIFY) { // Masternode Verify
 
         // Need LOCK2 here to ensure consistent locking order because all functions below call GetBlockHash which locks cs_main
@@ -933,23 +1092,80 @@ void CMasternodeMan::SyncAll(CNode* pnode, CConnman* connman)
     // do not provide any data until our node is synced
     if (!masternodeSync.IsSynced()) return;
 
+    if (!AllowListRequest(pnode)) return;
+
+    PushEnabledInvs(pnode, connman);
+}
+
+void CMasternodeMan::SyncDelta(CNode* pnode, int nHeight, CConnman* connman)
+{
+    // do not provide any data until our node is synced
+    if (!masternodeSync.IsSynced()) return;
+
+    // a delta is cheaper than the full list but still walks every masternode, so it shares the rate limit
+    if (!AllowListRequest(pnode)) return;
+
+    int64_t nTimeSince = 0;
+    {
+        LOCK(cs_main);
+        if (nHeight >= 0 && nHeight <= chainActive.Height()) nTimeSince = chainActive[nHeight]->GetBlockTime();
+    }
+
+    LOCK(cs);
+
+    // Masternodes that kept their state are not sent: the peer holds a ping of each from at most
+    // MASTERNODE_MIN_MNP_SECONDS before nTimeSince and the next one reaches it through the normal
+    // relay before that expires, as long as nTimeSince is no older than DSEG_DELTA_MAX_SECONDS.
+    if (nJournalStartHeight < 0 || nHeight <= nJournalStartHeight || nHeight > nCachedBlockHeight ||
+        GetAdjustedTime() - nTimeSince > DSEG_DELTA_MAX_SECONDS) {
+        LogPrint(BCLog::MNODE, "CMasternodeMan::%s -- no delta since height %d, sending the full list to peer=%d\n", __func__, nHeight, pnode->GetId());
+        PushEnabledInvs(pnode, connman);
+        return;
+    }
+
+    int nInvCount = 0;
+
+    // walk the rows since nHeight newest first, the latest state of each masternode decides
+    std::set<COutPoint> setSeen;
+    const size_t nFirstRow = std::lower_bound(journal.vHeight.begin(), journal.vHeight.end(), nHeight) - journal.vHeight.begin();
+    for (size_t nRow = journal.vHeight.size(); nRow > nFirstRow; nRow--) {
+        const COutPoint& outpoint = journal.vOutpoint[nRow - 1];
+        if (!setSeen.insert(outpoint).second) continue;
+        // NOTE: as in SyncAll, only ENABLED nodes are sent, the peer expires the others by itself
+        if (journal.vActiveState[nRow - 1] != CMasternode::MASTERNODE_ENABLED) continue;
+        auto it = mapMasternodes.find(outpoint);
+        if (it == mapMasternodes.end() || !it->second.IsEnabled()) continue;
+        if (it->second.addr.IsRFC1918() || it->second.addr.IsLocal()) continue; // do not send local network masternode
+        PushDsegInvs(pnode, it->second);
+        nInvCount++;
+    }
+
+    connman->PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_LIST, nInvCount));
+    LogPrintf("CMasternodeMan::%s -- Sent %d Masternode invs changed since height %d to peer=%d\n", __func__, nInvCount, nHeight, pnode->GetId());
+}
+
+bool CMasternodeMan::AllowListRequest(CNode* pnode)
+{
     // local network
     bool isLocal = (pnode->addr.IsRFC1918() || pnode->addr.IsLocal());
+    if (isLocal || Params().NetworkIDString() != CBaseChainParams::MAIN) return true;
 
     CService addrSquashed = Params().AllowMultiplePorts() ? (CService)pnode->addr : CService(pnode->addr, 0);
     // should only ask for this once
-    if (!isLocal && Params().NetworkIDString() == CBaseChainParams::MAIN) {
-        LOCK2(cs_main, cs);
-        auto it = mAskedUsForMasternodeList.find(addrSquashed);
-        if (it != mAskedUsForMasternodeList.end() && it->second > GetTime()) {
-            Misbehaving(pnode->GetId(), 34);
-            LogPrintf("CMasternodeMan::%s -- peer already asked me for the list, peer=%d\n", __func__, pnode->GetId());
-            return;
-        }
-        int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
-        mAskedUsForMasternodeList[addrSquashed] = askAgain;
+    LOCK2(cs_main, cs);
+    auto it = mAskedUsForMasternodeList.find(addrSquashed);
+    if (it != mAskedUsForMasternodeList.end() && it->second > GetTime()) {
+        Misbehaving(pnode->GetId(), 34);
+        LogPrintf("CMasternodeMan::%s -- peer already asked me for the list, peer=%d\n", __func__, pnode->GetId());
+        return false;
     }
+    int64_t askAgain = GetTime() + DSEG_UPDATE_SECONDS;
+    mAskedUsForMasternodeList[addrSquashed] = askAgain;
+    return true;
+}
 
+void CMasternodeMan::PushEnabledInvs(CNode* pnode, CConnman* connman)
+{
     int nInvCount = 0;
 
     LOCK(cs);
@@ -990,25 +1206,30 @@ void CMasternodeMan::DoFullVerificationStep(CConnman* connman)
     if (activeMasternode.outpoint.IsNull()) return;
     if (!masternodeSync.IsSynced()) return;
 
-    rank_pair_vec_t vecMasternodeRanks;
-    GetMasternodeRanks(vecMasternodeRanks, nCachedBlockHeight - 1, MIN_POSE_PROTO_VERSION);
+    uint256 blockHash;
+    if (!HasBlockHash(blockHash, nCachedBlockHeight - 1)) {
+        LogPrintf("CMasternodeMan::%s -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", __func__, nCachedBlockHeight - 1);
+        return;
+    }
 
     LOCK(cs);
 
+    const score_pair_vec_t& vecMasternodeScores = GetMasternodeScores(blockHash, MIN_POSE_PROTO_VERSION);
+
     int nCount = 0;
 
     int nMyRank = -1;
-    int nRanksTotal = (int)vecMasternodeRanks.size();
+    int nRanksTotal = (int)vecMasternodeScores.size();
 
     // send verify requests only if we are in top MAX_POSE_RANK
-    for (auto& rankPair : vecMasternodeRanks) {
-        if (rankPair.first > MAX_POSE_RANK) {
+    for (int i = 0; i < nRanksTotal; i++) {
+        if (i + 1 > MAX_POSE_RANK) {
             LogPrint(BCLog::MNODE, "CMasternodeMan::DoFullVerificationStep -- Must be in top %d to send verify request\n",
                         (int)MAX_POSE_RANK);
             return;
         }
-        if (rankPair.second.outpoint == activeMasternode.outpoint) {
-            nMyRank = rankPair.first;
+        if (vecMasternodeScores[i].second->outpoint == activeMasternode.outpoint) {
+            nMyRank = i + 1;
             LogPrint(BCLog::MNODE, "CMasternodeMan::DoFullVerificationStep -- Found self at rank %d/%d, verifying up to %d masternodes\n",
                         nMyRank, nRanksTotal, (int)MAX_POSE_CONNECTIONS);
             break;
@@ -1020,38 +1241,22 @@ void CMasternodeMan::DoFullVerificationStep(CConnman* connman)
 
     // send verify requests to up to MAX_POSE_CONNECTIONS masternodes
     // starting from MAX_POSE_RANK + nMyRank and using MAX_POSE_CONNECTIONS as a step
-    int nOffset = MAX_POSE_RANK + nMyRank - 1;
-    if (nOffset >= (int)vecMasternodeRanks.size()) return;
-
-    std::vector<const CMasternode*> vSortedByAddr;
-    for (const auto& mnpair : mapMasternodes) {
-        vSortedByAddr.push_back(&mnpair.second);
-    }
-
-    std::sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
-
-    auto it = vecMasternodeRanks.begin() + nOffset;
-    while(it != vecMasternodeRanks.end()) {
-        if (it->second.IsPoSeVerified() || it->second.IsPoSeBanned()) {
+    for (int nOffset = MAX_POSE_RANK + nMyRank - 1; nOffset < nRanksTotal; nOffset += MAX_POSE_CONNECTIONS) {
+        const CMasternode& mn = *vecMasternodeScores[nOffset].second;
+        if (mn.IsPoSeVerified() || mn.IsPoSeBanned()) {
             LogPrint(BCLog::MNODE, "CMasternodeMan::DoFullVerificationStep -- Already %s%s%s masternode %s address %s, skipping...\n",
-                        it->second.IsPoSeVerified() ? "verified" : "",
-                        it->second.IsPoSeVerified() && it->second.IsPoSeBanned() ? " and " : "",
-                        it->second.IsPoSeBanned() ? "banned" : "",
-                        it->second.outpoint.ToStringShort(), it->second.addr.ToString());
-            nOffset += MAX_POSE_CONNECTIONS;
-            if (nOffset >= (int)vecMasternodeRanks.size()) break;
-            it += MAX_POSE_CONNECTIONS;
+                        mn.IsPoSeVerified() ? "verified" : "",
+                        mn.IsPoSeVerified() && mn.IsPoSeBanned() ? " and " : "",
+                        mn.IsPoSeBanned() ? "banned" : "",
+                        mn.outpoint.ToStringShort(), mn.addr.ToString());
             continue;
         }
         LogPrint(BCLog::MNODE, "CMasternodeMan::DoFullVerificationStep -- Verifying masternode %s rank %d/%d address %s\n",
-                    it->second.outpoint.ToStringShort(), it->first, nRanksTotal, it->second.addr.ToString());
-        if (SendVerifyRequest(CAddress(it->second.addr, NODE_NETWORK), vSortedByAddr, connman)) {
+                    mn.outpoint.ToStringShort(), nOffset + 1, nRanksTotal, mn.addr.ToString());
+        if (SendVerifyRequest(CAddress(mn.addr, NODE_NETWORK), connman)) {
             nCount++;
             if (nCount >= MAX_POSE_CONNECTIONS) break;
         }
-        nOffset += MAX_POSE_CONNECTIONS;
-        if (nOffset >= (int)vecMasternodeRanks.size()) break;
-        it += MAX_POSE_CONNECTIONS;
     }
 
     LogPrint(BCLog::MNODE, "CMasternodeMan::DoFullVerificationStep -- Sent verification requests to %d masternodes\n", nCount);
@@ -1067,31 +1272,28 @@ void CMasternodeMan::CheckSameAddr()
     if (!masternodeSync.IsSynced() || mapMasternodes.empty()) return;
 
     std::vector<CMasternode*> vBan;
-    std::vector<CMasternode*> vSortedByAddr;
 
     {
         LOCK(cs);
 
-        CMasternode* pprevMasternode = nullptr;
-        CMasternode* pverifiedMasternode = nullptr;
-
-        for (auto& mnpair : mapMasternodes) {
-            vSortedByAddr.push_back(&mnpair.second);
-        }
-
-        std::sort(vSortedByAddr.begin(), vSortedByAddr.end(), CompareByAddr());
-
-        for (const auto& pmn : vSortedByAddr) {
-            // check only (pre)enabled masternodes
-            if (!pmn->IsEnabled() && !pmn->IsPreEnabled()) continue;
-            // initial step
-            if (!pprevMasternode) {
-                pprevMasternode = pmn;
-                pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : nullptr;
-                continue;
-            }
-            // second+ step
-            if (pmn->addr == pprevMasternode->addr) {
+        for (const auto& addrpair : mapOutpointsByAddr) {
+            // a masternode alone at its address has no duplicates
+            if (addrpair.second.size() < 2) continue;
+
+            CMasternode* pprevMasternode = nullptr;
+            CMasternode* pverifiedMasternode = nullptr;
+
+            for (const auto& outpoint : addrpair.second) {
+                CMasternode* pmn = Find(outpoint);
+                // check only (pre)enabled masternodes
+                if (!pmn || (!pmn->IsEnabled() && !pmn->IsPreEnabled())) continue;
+                // initial step
+                if (!pprevMasternode) {
+                    pprevMasternode = pmn;
+                    pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : nullptr;
+                    continue;
+                }
+                // second+ step
                 if (pverifiedMasternode) {
                     // another masternode with the same ip is verified, ban this one
                     vBan.push_back(pmn);
@@ -1101,10 +1303,8 @@ void CMasternodeMan::CheckSameAddr()
                     // and keep a reference to be able to ban following masternodes with the same ip
                     pverifiedMasternode = pmn;
                 }
-            } else {
-                pverifiedMasternode = pmn->IsPoSeVerified() ? pmn : nullptr;
+                pprevMasternode = pmn;
             }
-            pprevMasternode = pmn;
         }
     }
 
@@ -1115,7 +1315,7 @@ void CMasternodeMan::CheckSameAddr()
     }
 }
 
-bool CMasternodeMan::SendVerifyRequest(const CAddress& addr, const std::vector<const CMasternode*>& vSortedByAddr, CConnman* connman)
+bool CMasternodeMan::SendVerifyRequest(const CAddress& addr, CConnman* connman)
 {
     if (netfulfilledman.HasFulfilledRequest(addr, strprintf("%s", NetMsgType::MNVERIFY)+"-request")) {
         // we already asked for verification, not a good idea to do this too often, skip it
@@ -1211,8 +1411,6 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
 {
     AssertLockHeld(cs_main);
 
-    std::string strError;
-
     // did we even ask for it? if that's the case we should have matching fulfilled request
     if (!netfulfilledman.HasFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-request")) {
         LogPrintf("CMasternodeMan::ProcessVerifyReply -- ERROR: we didn't ask for verification of %s, peer=%d\n", pnode->addr.ToString(), pnode->GetId());
@@ -1257,48 +1455,53 @@ void CMasternodeMan::ProcessVerifyReply(CNode* pnode, CMasternodeVerification& m
         std::vector<CMasternode*> vpMasternodesToBan;
 
         uint256 hash1 = mnv.GetSignatureHash1(blockHash);
-        std::string strMessage1 = strprintf("%s%d%s", pnode->addr.ToString(), mnv.nonce, blockHash.ToString());
-
-        for (auto& mnpair : mapMasternodes) {
-            if (CAddress(mnpair.second.addr, NODE_NETWORK) == pnode->addr) {
-                bool fFound = false;
-                fFound = CHashSigner::VerifyHash(hash1, mnpair.second.pubKeyMasternode, mnv.vchSig1, strError);
-                if (fFound) {
-                    // found it!
-                    prealMasternode = &mnpair.second;
-                    if (!mnpair.second.IsPoSeVerified()) {
-                        mnpair.second.DecreasePoSeBanScore();
-                    }
-                    netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
-
-                    // we can only broadcast it if we are an activated masternode
-                    if (activeMasternode.outpoint.IsNull()) continue;
-                    // update ...
-                    mnv.addr = mnpair.second.addr;
-                    mnv.masternodeOutpoint1 = mnpair.second.outpoint;
-                    mnv.masternodeOutpoint2 = activeMasternode.outpoint;
-                    // ... and sign it
-                    std::string strError;
-
-                    uint256 hash2 = mnv.GetSignatureHash2(blockHash);
-
-                    if (!CHashSigner::SignHash(hash2, activeMasternode.keyMasternode, mnv.vchSig2)) {
-                        LogPrintf("MasternodeMan::ProcessVerifyReply -- SignHash() failed\n");
-                        return;
-                    }
 
-                    if (!CHashSigner::VerifyHash(hash2, activeMasternode.pubKeyMasternode, mnv.vchSig2, strError)) {
-                        LogPrintf("MasternodeMan::ProcessVerifyReply -- VerifyHash() failed, error: %s\n", strError);
-                        return;
-                    }
+        // a single key recovery tells which of the masternodes at this address signed the reply
+        CPubKey pubKeySigner;
+        if (!CHashSigner::RecoverPubKey(hash1, mnv.vchSig1, pubKeySigner)) {
+            pubKeySigner = CPubKey();
+        }
 
-                    mWeAskedForVerification[pnode->addr] = mnv;
-                    mapSeenMasternodeVerification.insert(std::make_pair(mnv.GetHash(), mnv));
-                    mnv.Relay();
+        auto itAddr = mapOutpointsByAddr.find(pnode->addr);
+        const std::set<COutPoint> setOutpoints = itAddr == mapOutpointsByAddr.end() ? std::set<COutPoint>() : itAddr->second;
+        for (const COutPoint& outpoint : setOutpoints) {
+            auto& mnpair = *mapMasternodes.find(outpoint);
+            bool fFound = pubKeySigner.IsValid() && mnpair.second.pubKeyMasternode == pubKeySigner;
+            if (fFound) {
+                // found it!
+                prealMasternode = &mnpair.second;
+                if (!mnpair.second.IsPoSeVerified()) {
+                    mnpair.second.DecreasePoSeBanScore();
+                }
+                netfulfilledman.AddFulfilledRequest(pnode->addr, strprintf("%s", NetMsgType::MNVERIFY)+"-done");
+
+                // we can only broadcast it if we are an activated masternode
+                if (activeMasternode.outpoint.IsNull()) continue;
+                // update ...
+                mnv.addr = mnpair.second.addr;
+                mnv.masternodeOutpoint1 = mnpair.second.outpoint;
+                mnv.masternodeOutpoint2 = activeMasternode.outpoint;
+                // ... and sign it
+                std::string strError;
+
+                uint256 hash2 = mnv.GetSignatureHash2(blockHash);
+
+                if (!CHashSigner::SignHash(hash2, activeMasternode.keyMasternode, mnv.vchSig2)) {
+                    LogPrintf("MasternodeMan::ProcessVerifyReply -- SignHash() failed\n");
+                    return;
+                }
 
-                } else {
-                    vpMasternodesToBan.push_back(&mnpair.second);
+                if (!CHashSigner::VerifyHash(hash2, activeMasternode.pubKeyMasternode, mnv.vchSig2, strError)) {
+                    LogPrintf("MasternodeMan::ProcessVerifyReply -- VerifyHash() failed, error: %s\n", strError);
+                    return;
                 }
+
+                mWeAskedForVerification[pnode->addr] = mnv;
+                mapSeenMasternodeVerification.insert(std::make_pair(mnv.GetHash(), mnv));
+                mnv.Relay();
+
+            } else {
+                vpMasternodesToBan.push_back(&mnpair.second);
             }
         }
         // no real masternode found?...
@@ -1496,7 +1699,12 @@ bool CMasternodeMan::CheckMnbAndUpdateMasternodeList(CNode* pfrom, CMasternodeBr
         CMasternode* pmn = Find(mnb.outpoint);
         if (pmn) {
             CMasternodeBroadcast mnbOld = mapSeenMasternodeBroadcast[CMasternodeBroadcast(*pmn).GetHash()].second;
-            if (!mnb.Update(pmn, nDos, connman)) {
+            // the broadcast may move the masternode to a new address or key
+            UnindexMasternode(*pmn);
+            const bool fUpdated = mnb.Update(pmn, nDos, connman);
+            IndexMasternode(*pmn);
+            ScheduleCheck(*pmn);
+            if (!fUpdated) {
                 LogPrint(BCLog::MNODE, "CMasternodeMan::CheckMnbAndUpdateMasternodeList -- Update() failed, masternode=%s\n", mnb.outpoint.ToStringShort());
                 return false;
             }
@@ -1591,11 +1799,9 @@ void CMasternodeMan::RemoveGovernanceObject(uint256 nGovernanceObjectHash)
 void CMasternodeMan::CheckMasternode(const CPubKey& pubKeyMasternode, bool fForce)
 {
     LOCK2(cs_main, cs);
-    for (auto& mnpair : mapMasternodes) {
-        if (mnpair.second.pubKeyMasternode == pubKeyMasternode) {
-            mnpair.second.Check(fForce);
-            return;
-        }
+    auto it = mapOutpointsByPubKey.find(pubKeyMasternode);
+    if (it != mapOutpointsByPubKey.end()) {
+        mapMasternodes.at(*it->second.begin()).Check(fForce);
     }
 }
 
@@ -1631,6 +1837,14 @@ void CMasternodeMan::UpdatedBlockTip(const CBlockIndex *pindexNew)
     nCachedBlockHeight = pindexNew->nHeight;
     LogPrint(BCLog::MNODE, "CMasternodeMan::UpdatedBlockTip -- nCachedBlockHeight=%d\n", nCachedBlockHeight);
 
+    if (masternodeSync.IsMasternodeListSynced()) {
+        LOCK(cs);
+        nLastSyncedHeight = nCachedBlockHeight;
+        // start journaling once our own list is complete
+        if (nJournalStartHeight < 0) nJournalStartHeight = nCachedBlockHeight;
+        PruneJournal();
+    }
+
     CheckSameAddr();
 
     if (fMasternodeMode) {
@@ -1736,8 +1950,8 @@ void CMasternodeMan::ClientTask(CConnman* connman)
 
     nTick++;
 
-    // make sure to check all masternodes first
-    mnodeman.Check();
+    // make sure to check the masternodes due first, CheckAndRemove below checks them all
+    mnodeman.CheckDue();
 
     mnodeman.ProcessPendingMnbRequests(connman);
     mnodeman.ProcessPendingMnvRequests(connman);
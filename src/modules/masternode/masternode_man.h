@@ -9,6 +9,8 @@
 #include <modules/masternode/masternode.h>
 #include <sync.h>
 
+#include <deque>
+
 class CMasternodeMan;
 class CConnman;
 
@@ -34,6 +36,14 @@ private:
     static const int MAX_POSE_RANK              = 10;
     static const int MAX_POSE_BLOCKS            = 10;
 
+    static const int MAX_CACHED_SCORES          = 16;
+
+    // a delta carries no pings, so it is only served while the requester's pings are
+    // younger than the expiry by more than the time its next relayed ping may take
+    static const int DSEG_DELTA_MAX_SECONDS     = MASTERNODE_EXPIRATION_SECONDS - 2 * MASTERNODE_MIN_MNP_SECONDS;
+    static const int JOURNAL_DEPTH_BLOCKS       = 1000;
+    static const size_t MAX_JOURNAL_ROWS        = 100000;
+
     static const int MNB_RECOVERY_QUORUM_TOTAL      = 10;
     static const int MNB_RECOVERY_QUORUM_REQUIRED   = 6;
     static const int MNB_RECOVERY_MAX_ASK_ENTRIES   = 10;
@@ -49,6 +59,33 @@ private:
 
     // map to hold all MNs
     std::map<COutPoint, CMasternode> mapMasternodes;
+    // secondary indexes of mapMasternodes, kept in step with it by IndexMasternode and UnindexMasternode
+    std::map<CService, std::set<COutPoint> > mapOutpointsByAddr;
+    std::map<CPubKey, std::set<COutPoint> > mapOutpointsByPubKey;
+    std::map<CScript, std::set<COutPoint> > mapOutpointsByPayee;
+    // sorted scores by block hash and minimum protocol, dropped whenever an entry is (un)indexed
+    std::map<std::pair<uint256, int>, score_pair_vec_t> mapCachedScores;
+
+    // Journal of masternode state changes in block height order, kept column by column.
+    // It holds every change at heights above nJournalStartHeight, so a peer whose list
+    // was synced at such a height only needs the masternodes that changed since.
+    struct StateJournal
+    {
+        std::deque<int> vHeight;
+        std::deque<COutPoint> vOutpoint;
+        std::deque<int> vActiveState;
+        std::deque<int> vProtocolVersion;
+    } journal;
+    int nJournalStartHeight;
+    // state and protocol of each masternode as of its last journal row
+    std::map<COutPoint, std::pair<int, int> > mapJournaledStates;
+    // last block height at which our list was synced
+    int nLastSyncedHeight;
+
+    // masternodes by the adjusted time at which their last ping gets old enough
+    // to change their state, so that the frequent checks only visit those
+    std::set<std::pair<int64_t, COutPoint> > setCheckQueue;
+    std::map<COutPoint, int64_t> mapNextCheckTime;
     // who's asked for the Masternode list and the last time
     std::map<CService, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -81,11 +118,32 @@ private:
     /// Find an entry
     CMasternode* Find(const COutPoint& outpoint);
 
-    bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
+    /// Add or remove an entry in the secondary indexes; an entry must be
+    /// unindexed before its address or keys change and indexed again after
+    void IndexMasternode(const CMasternode& mn);
+    void UnindexMasternode(const CMasternode& mn);
+    void RebuildIndexes();
+
+    /// Scores of all masternodes for a block, best first; valid while cs is held
+    const score_pair_vec_t& GetMasternodeScores(const uint256& nBlockHash, int nMinProtocol = 0);
+
+    /// Append a journal row if the state or protocol of a masternode changed since its last one
+    void JournalMasternode(const CMasternode& mn);
+    void PruneJournal();
+
+    /// Queue a masternode to be checked at nTime, or when its next ping age deadline passes if nTime is -1
+    void ScheduleCheck(const CMasternode& mn, int64_t nTime = -1);
+    void UnscheduleCheck(const COutPoint& outpoint);
 
     void SyncSingle(CNode* pnode, const COutPoint& outpoint);
     void SyncAll(CNode* pnode, CConnman* connman);
+    /// Sync only the masternodes that changed since nHeight, or everything if the journal
+    /// does not go back that far or nHeight is older than DSEG_DELTA_MAX_SECONDS
+    void SyncDelta(CNode* pnode, int nHeight, CConnman* connman);
 
+    /// Record a full or delta list request, false if the peer asked too recently
+    bool AllowListRequest(CNode* pnode);
+    void PushEnabledInvs(CNode* pnode, CConnman* connman);
     void PushDsegInvs(CNode* pnode, const CMasternode& mn);
 
 public:
@@ -120,9 +178,15 @@ public:
 
         READWRITE(mapSeenMasternodeBroadcast);
         READWRITE(mapSeenMasternodePing);
+        if (strVersion == SERIALIZATION_VERSION_STRING) {
+            READWRITE(nLastSyncedHeight);
+        }
         if (ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
+        if (ser_action.ForRead()) {
+            RebuildIndexes();
+        }
     }
 
     CMasternodeMan();
@@ -137,6 +201,8 @@ public:
 
     /// Check all Masternodes
     void Check();
+    /// Check only the Masternodes whose state may have changed with time since their last check
+    void CheckDue();
 
     /// Check all Masternodes and remove inactive
     void CheckAndRemove(CConnman* connman);
@@ -186,7 +252,7 @@ public:
 
     void DoFullVerificationStep(CConnman* connman);
     void CheckSameAddr();
-    bool SendVerifyRequest(const CAddress& addr, const std::vector<const CMasternode*>& vSortedByAddr, CConnman* connman);
+    bool SendVerifyRequest(const CAddress& addr, CConnman* connman);
     void ProcessPendingMnvRequests(CConnman* connman);
     void SendVerifyReply(CNode* pnode, CMasternodeVerification& mnv, CConnman* connman);
     void ProcessVerifyReply(CNode* pnode, CMasternodeVerification& mnv);
@@ -174,6 +174,29 @@ void FillBlockPayments(CMutableTransaction& txNew, int nBlockHeight, CAmount blo
                             nBlockHeight, blockReward, txoutMasternodeRet.ToString(), txNew.GetHash().ToString());
 }
 
+/**
+*   ApplyBlockPayments
+*
+*   Re-add the payments previously selected by FillBlockPayments for this height
+*   to a coinbase with a different block reward, without selecting the payees again
+*/
+
+void ApplyBlockPayments(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternode, const std::vector<CTxOut>& voutSuperblock)
+{
+    // superblock payments don't depend on the block reward
+    if (!voutSuperblock.empty()) {
+        txNew.vout.insert(txNew.vout.end(), voutSuperblock.begin(), voutSuperblock.end());
+        return;
+    }
+
+    // no masternode was detected when the payments were filled
+    if (txoutMasternode.IsNull()) return;
+
+    txoutMasternode.nValue = GetMasternodePayment(nBlockHeight, blockReward);
+    txNew.vout[0].nValue -= txoutMasternode.nValue;
+    txNew.vout.push_back(txoutMasternode);
+}
+
 std::string GetRequiredPaymentsString(int nBlockHeight)
 {
     // IF WE HAVE A ACTIVATED TRIGGER FOR THIS HEIGHT - IT IS A SUPERBLOCK, GET THE REQUIRED PAYEES
@@ -190,6 +213,7 @@ void CMasternodePayments::Clear()
     LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePaymentVotes);
     mapMasternodeBlocks.clear();
     mapMasternodePaymentVotes.clear();
+    fScheduledPayeesDirty = true;
 }
 
 bool CMasternodePayments::UpdateLastVote(const CMasternodePaymentVote& vote)
@@ -405,6 +429,23 @@ bool CMasternodePayments::GetBlockPayee(int nBlockHeight, CScript& payeeRet) con
     return it != mapMasternodeBlocks.end() && it->second.GetBestPayee(payeeRet);
 }
 
+void CMasternodePayments::UpdateScheduledPayees() const
+{
+    AssertLockHeld(cs_mapMasternodeBlocks);
+
+    if (!fScheduledPayeesDirty && nScheduledPayeesHeight == nCachedBlockHeight) return;
+
+    mapScheduledPayees.clear();
+    CScript payee;
+    for (int h = nCachedBlockHeight; h <= nCachedBlockHeight + SCHEDULED_PAYMENT_BLOCKS; h++) {
+        if (GetBlockPayee(h, payee)) {
+            mapScheduledPayees[payee].push_back(h);
+        }
+    }
+    nScheduledPayeesHeight = nCachedBlockHeight;
+    fScheduledPayeesDirty = false;
+}
+
 // Is this masternode scheduled to get paid soon?
 // -- Only look ahead up to 8 blocks to allow for propagation of the latest 2 blocks of votes
 bool CMasternodePayments::IsScheduled(const masternode_info_t& mnInfo, int nNotBlockHeight) const
@@ -413,15 +454,13 @@ bool CMasternodePayments::IsScheduled(const masternode_info_t& mnInfo, int nNotB
 
     if (!masternodeSync.IsMasternodeListSynced()) return false;
 
-    CScript mnpayee;
-    mnpayee = GetScriptForDestination(mnInfo.collDest);
+    UpdateScheduledPayees();
 
-    CScript payee;
-    for(int64_t h = nCachedBlockHeight; h <= nCachedBlockHeight + 8; h++){
-        if (h == nNotBlockHeight) continue;
-        if (GetBlockPayee(h, payee) && mnpayee == payee) {
-            return true;
-        }
+    const auto it = mapScheduledPayees.find(GetScriptForDestination(mnInfo.collDest));
+    if (it == mapScheduledPayees.end()) return false;
+
+    for (int h : it->second) {
+        if (h != nNotBlockHeight) return true;
     }
 
     return false;
@@ -442,6 +481,7 @@ bool CMasternodePayments::AddOrUpdatePaymentVote(const CMasternodePaymentVote& v
 
     auto it = mapMasternodeBlocks.emplace(vote.nBlockHeight, CMasternodeBlockPayees(vote.nBlockHeight)).first;
     it->second.AddPayee(vote);
+    fScheduledPayeesDirty = true;
 
     LogPrint(BCLog::MNODEPAY, "CMasternodePayments::AddOrUpdatePaymentVote -- added, hash=%s\n", nVoteHash.ToString());
 
@@ -608,6 +648,7 @@ void CMasternodePayments::CheckAndRemove()
             ++it;
         }
     }
+    fScheduledPayeesDirty = true;
     LogPrint(BCLog::MNODEPAY, "CMasternodePayments::CheckAndRemove -- %s\n", ToString());
 }
 
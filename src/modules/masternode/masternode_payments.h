@@ -32,6 +32,7 @@ extern CMasternodePayments mnpayments;
 bool IsBlockValueValid(const CBlock& block, int nBlockHeight, CAmount blockReward, std::string& strErrorRet);
 bool IsBlockPayeeValid(const CTransactionRef& txNew, int nBlockHeight, CAmount blockReward);
 void FillBlockPayments(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternodeRet, std::vector<CTxOut>& voutSuperblockRet);
+void ApplyBlockPayments(CMutableTransaction& txNew, int nBlockHeight, CAmount blockReward, CTxOut& txoutMasternode, const std::vector<CTxOut>& voutSuperblock);
 std::string GetRequiredPaymentsString(int nBlockHeight);
 
 class CMasternodePayee
@@ -168,13 +169,26 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    // How many blocks past the current one IsScheduled looks at
+    static const int SCHEDULED_PAYMENT_BLOCKS = 8;
+
+    // Heights at which each payee has the most votes among the blocks
+    // IsScheduled looks at, computed for nScheduledPayeesHeight. Guarded by
+    // cs_mapMasternodeBlocks and recomputed lazily once marked dirty by a
+    // new vote or the tip moving.
+    mutable std::map<CScript, std::vector<int> > mapScheduledPayees;
+    mutable int nScheduledPayeesHeight;
+    mutable bool fScheduledPayeesDirty;
+
+    void UpdateScheduledPayees() const;
+
 public:
     std::map<uint256, CMasternodePaymentVote> mapMasternodePaymentVotes;
     std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
     std::map<COutPoint, int> mapMasternodesLastVote;
     std::map<COutPoint, int> mapMasternodesDidNotVote;
 
-    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000) {}
+    CMasternodePayments() : nStorageCoeff(1.25), nMinBlocksToStore(5000), nScheduledPayeesHeight(-1), fScheduledPayeesDirty(true) {}
 
     ADD_SERIALIZE_METHODS;
 
@@ -182,6 +196,9 @@ public:
     inline void SerializationOp(Stream& s, Operation ser_action) {
         READWRITE(mapMasternodePaymentVotes);
         READWRITE(mapMasternodeBlocks);
+        if (ser_action.ForRead()) {
+            fScheduledPayeesDirty = true;
+        }
     }
 
     void Clear();
@@ -520,13 +520,19 @@ void CNode::copyStats(CNodeStats &stats)
     {
         LOCK(cs_vSend);
         X(mapSendBytesPerMsgCmd);
+        X(mapSendMsgsPerMsgCmd);
         X(nSendBytes);
     }
     {
         LOCK(cs_vRecv);
         X(mapRecvBytesPerMsgCmd);
+        X(mapRecvMsgsPerMsgCmd);
         X(nRecvBytes);
     }
+    {
+        LOCK(cs_vProcessMsg);
+        X(mapProcessTimePerMsgCmd);
+    }
     X(fWhitelisted);
     {
         LOCK(cs_feeFilter);
@@ -597,6 +603,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
                 i = mapRecvBytesPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
             assert(i != mapRecvBytesPerMsgCmd.end());
             i->second += msg.hdr.nMessageSize + CMessageHeader::HEADER_SIZE;
+            mapRecvMsgsPerMsgCmd[i->first]++;
 
             msg.nTime = nTimeMicros;
             complete = true;
@@ -1325,6 +1332,7 @@ void CConnman::SocketHandler()
                         if (!it->complete())
                             break;
                         nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
+                        RecordMsgRecv(it->hdr.GetCommand(), it->vRecv.size() + CMessageHeader::HEADER_SIZE);
                     }
                     {
                         LOCK(pnode->cs_vProcessMsg);
@@ -2176,6 +2184,10 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In) : nSeed0(nSeed0In), nSe
 {
     SetTryNewOutboundPeer(false);
 
+    for (const std::string &msg : getAllNetMessageTypes())
+        mapMsgStats[msg];
+    mapMsgStats[NET_MESSAGE_COMMAND_OTHER];
+
     Options connOptions;
     Init(connOptions);
 }
@@ -2586,6 +2598,41 @@ void CConnman::RecordBytesRecv(uint64_t bytes)
     nTotalBytesRecv += bytes;
 }
 
+void CConnman::RecordMsgRecv(const std::string& command, uint64_t bytes)
+{
+    LOCK(cs_msgStats);
+    // to prevent a memory DOS, only valid commands get their own entry
+    mapMsgCmdStats::iterator it = mapMsgStats.find(command);
+    if (it == mapMsgStats.end())
+        it = mapMsgStats.find(NET_MESSAGE_COMMAND_OTHER);
+    it->second.nRecvMsgs++;
+    it->second.nRecvBytes += bytes;
+}
+
+void CConnman::RecordMsgSent(const std::string& command, uint64_t bytes)
+{
+    LOCK(cs_msgStats);
+    CMsgCmdStats& stats = mapMsgStats[command];
+    stats.nSendMsgs++;
+    stats.nSendBytes += bytes;
+}
+
+void CConnman::RecordMsgProcessed(CNode* pnode, const std::string& command, int64_t nTimeMicros)
+{
+    {
+        LOCK(pnode->cs_vProcessMsg);
+        mapMsgCmdSize::iterator it = pnode->mapProcessTimePerMsgCmd.find(command);
+        if (it == pnode->mapProcessTimePerMsgCmd.end())
+            it = pnode->mapProcessTimePerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
+        it->second += nTimeMicros;
+    }
+    LOCK(cs_msgStats);
+    mapMsgCmdStats::iterator it = mapMsgStats.find(command);
+    if (it == mapMsgStats.end())
+        it = mapMsgStats.find(NET_MESSAGE_COMMAND_OTHER);
+    it->second.nProcessTime += nTimeMicros;
+}
+
 void CConnman::RecordBytesSent(uint64_t bytes)
 {
     LOCK(cs_totalBytesSent);
@@ -2688,6 +2735,12 @@ uint64_t CConnman::GetTotalBytesSent()
     return nTotalBytesSent;
 }
 
+mapMsgCmdStats CConnman::GetMsgStats()
+{
+    LOCK(cs_msgStats);
+    return mapMsgStats;
+}
+
 ServiceFlags CConnman::GetLocalServices() const
 {
     return nLocalServices;
@@ -2725,9 +2778,14 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     filterInventoryKnown.reset();
     pfilter = MakeUnique<CBloomFilter>();
 
-    for (const std::string &msg : getAllNetMessageTypes())
+    for (const std::string &msg : getAllNetMessageTypes()) {
         mapRecvBytesPerMsgCmd[msg] = 0;
+        mapRecvMsgsPerMsgCmd[msg] = 0;
+        mapProcessTimePerMsgCmd[msg] = 0;
+    }
     mapRecvBytesPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
+    mapRecvMsgsPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
+    mapProcessTimePerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
 
     if (fLogIPs) {
         LogPrint(BCLog::NET, "Added connection to %s peer=%d\n", addrName, id);
@@ -2767,6 +2825,7 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 
         //log total amount of bytes per command
         pnode->mapSendBytesPerMsgCmd[msg.command] += nTotalSize;
+        pnode->mapSendMsgsPerMsgCmd[msg.command]++;
         pnode->nSendSize += nTotalSize;
 
         if (pnode->nSendSize > nSendBufferMaxSize)
@@ -2781,6 +2840,7 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
     }
     if (nBytesSent)
         RecordBytesSent(nBytesSent);
+    RecordMsgSent(msg.command, nTotalSize);
 }
 
 
@@ -111,6 +111,18 @@ struct CSerializedNetMsg
 };
 
 
+/** Traffic and processing time of one message type */
+struct CMsgCmdStats
+{
+    uint64_t nRecvMsgs{0};
+    uint64_t nRecvBytes{0};
+    uint64_t nSendMsgs{0};
+    uint64_t nSendBytes{0};
+    int64_t nProcessTime{0}; //!< microseconds spent processing received messages
+};
+typedef std::map<std::string, CMsgCmdStats> mapMsgCmdStats; //command, stats
+
+
 class NetEventsInterface;
 class CConnman
 {
@@ -331,6 +343,11 @@ public:
     uint64_t GetTotalBytesRecv();
     uint64_t GetTotalBytesSent();
 
+    //! Traffic and processing time per message type, over all peers since startup
+    mapMsgCmdStats GetMsgStats();
+    //! Account the time spent processing a message received from a peer
+    void RecordMsgProcessed(CNode* pnode, const std::string& command, int64_t nTimeMicros);
+
     void SetBestHeight(int height);
     int GetBestHeight() const;
 
@@ -395,6 +412,8 @@ private:
     // Network stats
     void RecordBytesRecv(uint64_t bytes);
     void RecordBytesSent(uint64_t bytes);
+    void RecordMsgRecv(const std::string& command, uint64_t bytes);
+    void RecordMsgSent(const std::string& command, uint64_t bytes);
 
     // Whether the node should be passed out in ForEach* callbacks
     static bool NodeFullyConnected(const CNode* pnode);
@@ -405,6 +424,10 @@ private:
     uint64_t nTotalBytesRecv GUARDED_BY(cs_totalBytesRecv);
     uint64_t nTotalBytesSent GUARDED_BY(cs_totalBytesSent);
 
+    // Network usage and processing time per message type
+    CCriticalSection cs_msgStats;
+    mapMsgCmdStats mapMsgStats GUARDED_BY(cs_msgStats);
+
     // outbound limit & stats
     uint64_t nMaxOutboundTotalBytesSentInCycle GUARDED_BY(cs_totalBytesSent);
     uint64_t nMaxOutboundCycleStartTime GUARDED_BY(cs_totalBytesSent);
@@ -594,8 +617,11 @@ public:
     int nStartingHeight;
     uint64_t nSendBytes;
     mapMsgCmdSize mapSendBytesPerMsgCmd;
+    mapMsgCmdSize mapSendMsgsPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdSize mapRecvMsgsPerMsgCmd;
+    mapMsgCmdSize mapProcessTimePerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -716,6 +742,8 @@ public:
     bool fRelayTxes GUARDED_BY(cs_filter){false};
     // If 'true' this node will be disconnected on CMasternodeMan::ProcessMasternodeConnections()
     bool fMasternode{false};
+    // Whether the node answers dsegdelta, as announced with sendmndelta
+    std::atomic<bool> fSupportsDsegDelta{false};
     bool fSentAddr{false};
     CSemaphoreGrant grantOutbound;
     CSemaphoreGrant grantMasternodeOutbound;
@@ -729,7 +757,10 @@ public:
 
 protected:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
+    mapMsgCmdSize mapSendMsgsPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd GUARDED_BY(cs_vRecv);
+    mapMsgCmdSize mapRecvMsgsPerMsgCmd GUARDED_BY(cs_vRecv);
+    mapMsgCmdSize mapProcessTimePerMsgCmd GUARDED_BY(cs_vProcessMsg); //command, microseconds
 
 public:
     uint256 hashContinue;
@@ -13,6 +13,7 @@
 #include <consensus/validation.h>
 #include <hash.h>
 #include <merkleblock.h>
+#include <metrics.h>
 #include <netmessagemaker.h>
 #include <netbase.h>
 #include <policy/fees.h>
@@ -35,6 +36,7 @@
 #include <modules/masternode/masternode_man.h>
 #include <modules/coinjoin/coinjoin_server.h>
 
+#include <array>
 #include <memory>
 
 #if defined(NDEBUG)
@@ -1908,7 +1910,53 @@ void static ProcessOrphanTx(CConnman* connman, std::set<uint256>& orphan_work_se
     }
 }
 
-bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
+template <typename T>
+static uint256 GetRelayedObjectHash(CDataStream& vRecv)
+{
+    CDataStream ss(vRecv);
+    T obj;
+    ss >> obj;
+    return obj.GetHash();
+}
+
+/** Where the Chaincoin modules' messages are dispatched to */
+struct ModuleMessageRoute
+{
+    //! The module that processes the message, if any
+    NetMsgDest dest{NetMsgDest::MSG_NONE};
+    //! For objects relayed by inventory: the inventory type and how to get the object hash
+    int relay_inv_type{0};
+    uint256 (*relay_hash)(CDataStream& vRecv){nullptr};
+};
+
+/** Routes indexed by message type, so dispatching does not compare command strings */
+static const std::vector<ModuleMessageRoute> g_module_message_routes = [] {
+    std::vector<ModuleMessageRoute> routes(static_cast<size_t>(NetMsgId::UNKNOWN) + 1);
+    auto route = [&routes](NetMsgId msg_id, NetMsgDest dest, int relay_inv_type = 0, uint256 (*relay_hash)(CDataStream&) = nullptr) {
+        ModuleMessageRoute& route = routes[static_cast<size_t>(msg_id)];
+        route.dest = dest;
+        route.relay_inv_type = relay_inv_type;
+        route.relay_hash = relay_hash;
+    };
+    route(NetMsgId::MNANNOUNCE, NetMsgDest::MSG_MN_MAN, MSG_MASTERNODE_ANNOUNCE, GetRelayedObjectHash<CMasternodeBroadcast>);
+    route(NetMsgId::MNPING, NetMsgDest::MSG_MN_MAN, MSG_MASTERNODE_PING, GetRelayedObjectHash<CMasternodePing>);
+    route(NetMsgId::MNVERIFY, NetMsgDest::MSG_MN_MAN, MSG_MASTERNODE_VERIFY, GetRelayedObjectHash<CMasternodeVerification>);
+    route(NetMsgId::DSEG, NetMsgDest::MSG_MN_MAN);
+    route(NetMsgId::DSEGDELTA, NetMsgDest::MSG_MN_MAN);
+    route(NetMsgId::MASTERNODEPAYMENTVOTE, NetMsgDest::MSG_MN_PAY, MSG_MASTERNODE_PAYMENT_VOTE, GetRelayedObjectHash<CMasternodePaymentVote>);
+    route(NetMsgId::MASTERNODEPAYMENTSYNC, NetMsgDest::MSG_MN_PAY);
+    route(NetMsgId::MNGOVERNANCEOBJECT, NetMsgDest::MSG_FUND, MSG_GOVERNANCE_OBJECT, GetRelayedObjectHash<CGovernanceObject>);
+    route(NetMsgId::MNGOVERNANCEOBJECTVOTE, NetMsgDest::MSG_FUND, MSG_GOVERNANCE_OBJECT_VOTE, GetRelayedObjectHash<CGovernanceVote>);
+    route(NetMsgId::MNGOVERNANCESYNC, NetMsgDest::MSG_FUND);
+    route(NetMsgId::SYNCSTATUSCOUNT, NetMsgDest::MSG_MN_SYNC);
+    for (NetMsgId msg_id : {NetMsgId::CJACCEPT, NetMsgId::CJTXIN, NetMsgId::CJFINALTX, NetMsgId::CJSIGNFINALTX,
+                            NetMsgId::CJCOMPLETE, NetMsgId::CJSTATUSUPDATE, NetMsgId::CJQUEUE}) {
+        route(msg_id, NetMsgDest::MSG_PSEND);
+    }
+    return routes;
+}();
+
+bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, NetMsgId msg_id, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
     if (gArgs.IsArgSet("-dropmessagestest") && GetRand(gArgs.GetArg("-dropmessagestest", 0)) == 0)
@@ -1919,8 +1967,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 
 
     if (!(pfrom->GetLocalServices() & NODE_BLOOM) &&
-              (strCommand == NetMsgType::FILTERLOAD ||
-               strCommand == NetMsgType::FILTERADD))
+              (msg_id == NetMsgId::FILTERLOAD ||
+               msg_id == NetMsgId::FILTERADD))
     {
         if (pfrom->nVersion >= NO_BLOOM_VERSION) {
             LOCK(cs_main);
@@ -1932,7 +1980,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         }
     }
 
-    if (strCommand == NetMsgType::REJECT)
+    if (msg_id == NetMsgId::REJECT)
     {
         if (LogAcceptCategory(BCLog::NET)) {
             try {
@@ -1957,7 +2005,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::VERSION) {
+    if (msg_id == NetMsgId::VERSION) {
         // Each connection can only send one version message
         if (pfrom->nVersion != 0)
         {
@@ -2141,7 +2189,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     // At this point, the outgoing message serialization version can't change.
     CNetMsgMaker msgMaker(pfrom->GetSendVersion());
 
-    if (strCommand == NetMsgType::VERACK)
+    if (msg_id == NetMsgId::VERACK)
     {
         pfrom->SetRecvVersion(std::min(pfrom->nVersion.load(), PROTOCOL_VERSION));
 
@@ -2174,6 +2222,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             nCMPCTBLOCKVersion = 1;
             connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, fAnnounceUsingCMPCTBLOCK, nCMPCTBLOCKVersion));
         }
+        // Tell our peer it may ask us for masternode list deltas. Peers that
+        // don't know the message ignore it, so no protocol version is needed.
+        connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SENDMNDELTA));
         pfrom->fSuccessfullyConnected = true;
         return true;
     }
@@ -2185,7 +2236,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return false;
     }
 
-    if (strCommand == NetMsgType::ADDR) {
+    if (msg_id == NetMsgId::ADDR) {
         std::vector<CAddress> vAddr;
         vRecv >> vAddr;
 
@@ -2236,13 +2287,18 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::SENDHEADERS) {
+    if (msg_id == NetMsgId::SENDHEADERS) {
         LOCK(cs_main);
         State(pfrom->GetId())->fPreferHeaders = true;
         return true;
     }
 
-    if (strCommand == NetMsgType::SENDCMPCT) {
+    if (msg_id == NetMsgId::SENDMNDELTA) {
+        pfrom->fSupportsDsegDelta = true;
+        return true;
+    }
+
+    if (msg_id == NetMsgId::SENDCMPCT) {
         bool fAnnounceUsingCMPCTBLOCK = false;
         uint64_t nCMPCTBLOCKVersion = 0;
         vRecv >> fAnnounceUsingCMPCTBLOCK >> nCMPCTBLOCKVersion;
@@ -2265,7 +2321,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::INV) {
+    if (msg_id == NetMsgId::INV) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
         if (vInv.size() > MAX_INV_SZ)
@@ -2323,7 +2379,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::GETDATA) {
+    if (msg_id == NetMsgId::GETDATA) {
         std::vector<CInv> vInv;
         vRecv >> vInv;
         if (vInv.size() > MAX_INV_SZ)
@@ -2344,7 +2400,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::GETBLOCKS) {
+    if (msg_id == NetMsgId::GETBLOCKS) {
         CBlockLocator locator;
         uint256 hashStop;
         vRecv >> locator >> hashStop;
@@ -2412,7 +2468,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::GETBLOCKTXN) {
+    if (msg_id == NetMsgId::GETBLOCKTXN) {
         BlockTransactionsRequest req;
         vRecv >> req;
 
@@ -2461,7 +2517,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::GETHEADERS) {
+    if (msg_id == NetMsgId::GETHEADERS) {
         CBlockLocator locator;
         uint256 hashStop;
         vRecv >> locator >> hashStop;
@@ -2528,7 +2584,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::TX) {
+    if (msg_id == NetMsgId::TX) {
         // Stop processing the transaction early if
         // We are in blocks only mode and peer is either not whitelisted or whitelistrelay is off
         if (!g_relay_txes && (!pfrom->fWhitelisted || !gArgs.GetBoolArg("-whitelistrelay", DEFAULT_WHITELISTRELAY)))
@@ -2685,151 +2741,28 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::MNANNOUNCE)
-    {
-        if (fReindex || fImporting || IsInitialBlockDownload()) return true;
-        {
-            LOCK(cs_main);
-
-            CDataStream ss(vRecv);
-            CMasternodeBroadcast mnb;
-            ss >> mnb;
-            CInv inv(MSG_MASTERNODE_ANNOUNCE, mnb.GetHash());
-            pfrom->AddInventoryKnown(inv);
-
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_MN_MAN, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
-
-            CNodeState* nodestate = State(pfrom->GetId());
-
-            nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
-            nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
-            EraseInvRequest(inv.hash);
-            return true;
-        }
-    }
-
-    if (strCommand == NetMsgType::MNPING)
-    {
-        if (fReindex || fImporting || IsInitialBlockDownload()) return true;
-        {
-            LOCK(cs_main);
-
-            CDataStream ss(vRecv);
-            CMasternodePing mnp;
-            ss >> mnp;
-            CInv inv(MSG_MASTERNODE_PING, mnp.GetHash());
-            pfrom->AddInventoryKnown(inv);
-
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_MN_MAN, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
-
-            CNodeState* nodestate = State(pfrom->GetId());
-
-            nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
-            nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
-            EraseInvRequest(inv.hash);
-            return true;
-        }
-    }
-
-    if (strCommand == NetMsgType::MNVERIFY)
+    const ModuleMessageRoute& route = g_module_message_routes[static_cast<size_t>(msg_id)];
+    if (route.relay_hash)
     {
         if (fReindex || fImporting || IsInitialBlockDownload()) return true;
-        {
-            LOCK(cs_main);
-
-            CDataStream ss(vRecv);
-            CMasternodeVerification mnv;
-            ss >> mnv;
-            CInv inv(MSG_MASTERNODE_VERIFY, mnv.GetHash());
-            pfrom->AddInventoryKnown(inv);
 
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_MN_MAN, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
-
-            CNodeState* nodestate = State(pfrom->GetId());
-
-            nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
-            nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
-            EraseInvRequest(inv.hash);
-            return true;
-        }
-    }
-
-    if (strCommand == NetMsgType::MASTERNODEPAYMENTVOTE)
-    {
-        if (fReindex || fImporting || IsInitialBlockDownload()) return true;
-        {
-            LOCK(cs_main);
-
-            CDataStream ss(vRecv);
-            CMasternodePaymentVote mnv;
-            ss >> mnv;
-            CInv inv(MSG_MASTERNODE_PAYMENT_VOTE, mnv.GetHash());
-            pfrom->AddInventoryKnown(inv);
-
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_MN_PAY, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
-
-            CNodeState* nodestate = State(pfrom->GetId());
-
-            nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
-            nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
-            EraseInvRequest(inv.hash);
-            return true;
-        }
-    }
-
-    if (strCommand == NetMsgType::MNGOVERNANCEOBJECT)
-    {
-        if (fReindex || fImporting || IsInitialBlockDownload()) return true;
-        {
-            LOCK(cs_main);
-
-            CDataStream ss(vRecv);
-            CGovernanceObject govobj;
-            ss >> govobj;
-            CInv inv(MSG_GOVERNANCE_OBJECT, govobj.GetHash());
-            pfrom->AddInventoryKnown(inv);
-
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_FUND, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
-
-            CNodeState* nodestate = State(pfrom->GetId());
-
-            nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
-            nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
-            EraseInvRequest(inv.hash);
-            return true;
-        }
-    }
-
-    if (strCommand == NetMsgType::MNGOVERNANCEOBJECTVOTE)
-    {
-        if (fReindex || fImporting || IsInitialBlockDownload()) return true;
-        {
-            LOCK(cs_main);
+        LOCK(cs_main);
 
-            CDataStream ss(vRecv);
-            CGovernanceVote vote;
-            ss >> vote;
-            CInv inv(MSG_GOVERNANCE_OBJECT_VOTE, vote.GetHash());
-            pfrom->AddInventoryKnown(inv);
+        CInv inv(route.relay_inv_type, route.relay_hash(vRecv));
+        pfrom->AddInventoryKnown(inv);
 
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_FUND, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
+        GetMainSignals().ProcessModuleMessage(pfrom, route.dest, strCommand, vRecv, connman);
+        LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
 
-            CNodeState* nodestate = State(pfrom->GetId());
+        CNodeState* nodestate = State(pfrom->GetId());
 
-            nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
-            nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
-            EraseInvRequest(inv.hash);
-            return true;
-        }
+        nodestate->m_inv_download.m_inv_announced.erase(inv.hash);
+        nodestate->m_inv_download.m_inv_in_flight.erase(inv.hash);
+        EraseInvRequest(inv.hash);
+        return true;
     }
 
-    if (strCommand == NetMsgType::CMPCTBLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
+    if (msg_id == NetMsgId::CMPCTBLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
     {
         CBlockHeaderAndShortTxIDs cmpctblock;
         vRecv >> cmpctblock;
@@ -3004,7 +2937,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         } // cs_main
 
         if (fProcessBLOCKTXN)
-            return ProcessMessage(pfrom, NetMsgType::BLOCKTXN, blockTxnMsg, nTimeReceived, chainparams, connman, interruptMsgProc, enable_bip61);
+            return ProcessMessage(pfrom, NetMsgType::BLOCKTXN, NetMsgId::BLOCKTXN, blockTxnMsg, nTimeReceived, chainparams, connman, interruptMsgProc, enable_bip61);
 
         if (fRevertToHeaderProcessing) {
             // Headers received from HB compact block peers are permitted to be
@@ -3051,7 +2984,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::BLOCKTXN && !fImporting && !fReindex) // Ignore blocks received while importing
+    if (msg_id == NetMsgId::BLOCKTXN && !fImporting && !fReindex) // Ignore blocks received while importing
     {
         BlockTransactions resp;
         vRecv >> resp;
@@ -3126,7 +3059,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::HEADERS && !fImporting && !fReindex) // Ignore headers received while importing
+    if (msg_id == NetMsgId::HEADERS && !fImporting && !fReindex) // Ignore headers received while importing
     {
         std::vector<CBlockHeader> headers;
 
@@ -3151,7 +3084,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return ProcessHeadersMessage(pfrom, connman, headers, chainparams, should_punish);
     }
 
-    if (strCommand == NetMsgType::BLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
+    if (msg_id == NetMsgId::BLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
     {
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
         vRecv >> *pblock;
@@ -3180,7 +3113,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::GETADDR) {
+    if (msg_id == NetMsgId::GETADDR) {
         // This asymmetric behavior for inbound and outbound connections was introduced
         // to prevent a fingerprinting attack: an attacker can send specific fake addresses
         // to users' AddrMan and later request them by sending getaddr messages.
@@ -3210,7 +3143,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::MEMPOOL) {
+    if (msg_id == NetMsgId::MEMPOOL) {
         if (!(pfrom->GetLocalServices() & NODE_BLOOM) && !pfrom->fWhitelisted)
         {
             LogPrint(BCLog::NET, "mempool request with bloom filters disabled, disconnect peer=%d\n", pfrom->GetId());
@@ -3230,7 +3163,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::PING) {
+    if (msg_id == NetMsgId::PING) {
         if (pfrom->nVersion > BIP0031_VERSION)
         {
             uint64_t nonce = 0;
@@ -3251,7 +3184,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::PONG) {
+    if (msg_id == NetMsgId::PONG) {
         int64_t pingUsecEnd = nTimeReceived;
         uint64_t nonce = 0;
         size_t nAvail = vRecv.in_avail();
@@ -3307,7 +3240,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::FILTERLOAD) {
+    if (msg_id == NetMsgId::FILTERLOAD) {
         CBloomFilter filter;
         vRecv >> filter;
 
@@ -3325,7 +3258,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::FILTERADD) {
+    if (msg_id == NetMsgId::FILTERADD) {
         std::vector<unsigned char> vData;
         vRecv >> vData;
 
@@ -3349,7 +3282,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::FILTERCLEAR) {
+    if (msg_id == NetMsgId::FILTERCLEAR) {
         LOCK(pfrom->cs_filter);
         if (pfrom->GetLocalServices() & NODE_BLOOM) {
             pfrom->pfilter.reset(new CBloomFilter());
@@ -3358,7 +3291,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::FEEFILTER) {
+    if (msg_id == NetMsgId::FEEFILTER) {
         CAmount newFeeFilter = 0;
         vRecv >> newFeeFilter;
         if (MoneyRange(newFeeFilter)) {
@@ -3371,7 +3304,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    if (strCommand == NetMsgType::NOTFOUND) {
+    if (msg_id == NetMsgId::NOTFOUND) {
         // Remove the NOTFOUND transactions from the peer
         LOCK(cs_main);
         CNodeState *state = State(pfrom->GetId());
@@ -3396,14 +3329,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         return true;
     }
 
-    const std::vector<std::string> &allMessages = getAllNetMessageTypes();
-    for (const auto& msg : allMessages) {
-        if(msg == strCommand) {
-            //probably for one of the modules
-            GetMainSignals().ProcessModuleMessage(pfrom, NetMsgDest::MSG_ALL, strCommand, vRecv, connman);
-            LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
-            break;
-        }
+    if (route.dest != NetMsgDest::MSG_NONE) {
+        GetMainSignals().ProcessModuleMessage(pfrom, route.dest, strCommand, vRecv, connman);
+        LogPrint(BCLog::NET, "Forwarded message \"%s\" from peer=%d to Chaincoin modules\n", SanitizeString(strCommand), pfrom->GetId());
+        return true;
     }
 
     // Ignore unknown commands for extensibility
@@ -3445,6 +3374,22 @@ bool PeerLogicValidation::SendRejectsAndCheckIfBanned(CNode* pnode, bool enable_
     return false;
 }
 
+/** Processing time histogram of a message type; unknown commands share one so peers cannot create metrics. */
+static MetricHistogram& MessageProcessHistogram(NetMsgId msg_id)
+{
+    // Resolved once, on first use: the message type names are statics of other translation units
+    static const std::array<MetricHistogram*, static_cast<size_t>(NetMsgId::UNKNOWN) + 1> histograms = [] {
+        std::array<MetricHistogram*, static_cast<size_t>(NetMsgId::UNKNOWN) + 1> ret;
+        const std::vector<std::string>& commands = getAllNetMessageTypes();
+        for (size_t i = 0; i < ret.size(); i++) {
+            ret[i] = &GetMetrics().Histogram("chaincoin_net_message_process_seconds", "Time spent processing received network messages",
+                "command", i < commands.size() ? commands[i] : NET_MESSAGE_COMMAND_OTHER);
+        }
+        return ret;
+    }();
+    return *histograms[static_cast<size_t>(msg_id)];
+}
+
 bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3510,6 +3455,7 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return fMoreWork;
     }
     std::string strCommand = hdr.GetCommand();
+    const NetMsgId msg_id = GetNetMsgId(strCommand);
 
     // Message size
     unsigned int nMessageSize = hdr.nMessageSize;
@@ -3530,7 +3476,11 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     bool fRet = false;
     try
     {
-        fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
+        const int64_t nProcessStart = GetTimeMicros();
+        fRet = ProcessMessage(pfrom, strCommand, msg_id, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
+        const int64_t nProcessTime = GetTimeMicros() - nProcessStart;
+        MessageProcessHistogram(msg_id).Observe(nProcessTime);
+        connman->RecordMsgProcessed(pfrom, strCommand, nProcessTime);
         if (interruptMsgProc)
             return false;
         if (!pfrom->vRecvGetData.empty())
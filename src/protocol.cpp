@@ -8,6 +8,8 @@
 #include <util/system.h>
 #include <util/strencodings.h>
 
+#include <unordered_map>
+
 #ifndef WIN32
 # include <arpa/inet.h>
 #endif
@@ -57,6 +59,8 @@ const char *CJCOMPLETE="cjc";
 const char *CJSTATUSUPDATE="cjsu";
 const char *CJQUEUE="cjq";
 const char *DSEG="dseg";
+const char *DSEGDELTA="dsegdelta";
+const char *SENDMNDELTA="sendmndelta";
 const char *SYNCSTATUSCOUNT="ssc";
 const char *MNGOVERNANCESYNC="govsync";
 const char *MNGOVERNANCEOBJECT="govobj";
@@ -109,6 +113,8 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::CJSTATUSUPDATE,
     NetMsgType::CJQUEUE,
     NetMsgType::DSEG,
+    NetMsgType::DSEGDELTA,
+    NetMsgType::SENDMNDELTA,
     NetMsgType::SYNCSTATUSCOUNT,
     NetMsgType::MNGOVERNANCESYNC,
     NetMsgType::MNGOVERNANCEOBJECT,
@@ -116,6 +122,15 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::MNVERIFY,
 };
 const static std::vector<std::string> allNetMessageTypesVec(allNetMessageTypes, allNetMessageTypes+ARRAYLEN(allNetMessageTypes));
+static_assert(ARRAYLEN(allNetMessageTypes) == static_cast<size_t>(NetMsgId::UNKNOWN), "NetMsgId must list every message type");
+
+const static std::unordered_map<std::string, NetMsgId> mapNetMsgIds = [] {
+    std::unordered_map<std::string, NetMsgId> ids;
+    for (size_t i = 0; i < ARRAYLEN(allNetMessageTypes); i++) {
+        ids.emplace(allNetMessageTypes[i], static_cast<NetMsgId>(i));
+    }
+    return ids;
+}();
 
 CMessageHeader::CMessageHeader(const MessageStartChars& pchMessageStartIn)
 {
@@ -245,3 +260,9 @@ const std::vector<std::string> &getAllNetMessageTypes()
 {
     return allNetMessageTypesVec;
 }
+
+NetMsgId GetNetMsgId(const std::string& command)
+{
+    auto it = mapNetMsgIds.find(command);
+    return it == mapNetMsgIds.end() ? NetMsgId::UNKNOWN : it->second;
+}
@@ -254,6 +254,8 @@ extern const char *CJCOMPLETE;
 extern const char *CJSTATUSUPDATE;
 extern const char *CJQUEUE;
 extern const char *DSEG;
+extern const char *DSEGDELTA;
+extern const char *SENDMNDELTA;
 extern const char *SYNCSTATUSCOUNT;
 extern const char *MNGOVERNANCESYNC;
 extern const char *MNGOVERNANCEOBJECT;
@@ -264,6 +266,63 @@ extern const char *MNVERIFY;
 /* Get a vector of all valid message types (see above) */
 const std::vector<std::string> &getAllNetMessageTypes();
 
+/** Dense identifiers of the valid message types, in the order of
+ * getAllNetMessageTypes(), so that received messages can be dispatched
+ * on an integer instead of comparing command strings.
+ */
+enum class NetMsgId : uint8_t {
+    VERSION,
+    VERACK,
+    ADDR,
+    INV,
+    GETDATA,
+    MERKLEBLOCK,
+    GETBLOCKS,
+    GETHEADERS,
+    TX,
+    HEADERS,
+    BLOCK,
+    GETADDR,
+    MEMPOOL,
+    PING,
+    PONG,
+    NOTFOUND,
+    FILTERLOAD,
+    FILTERADD,
+    FILTERCLEAR,
+    REJECT,
+    SENDHEADERS,
+    FEEFILTER,
+    SENDCMPCT,
+    CMPCTBLOCK,
+    GETBLOCKTXN,
+    BLOCKTXN,
+    // Chaincoin message types
+    MASTERNODEPAYMENTVOTE,
+    MASTERNODEPAYMENTSYNC,
+    MNANNOUNCE,
+    MNPING,
+    CJACCEPT,
+    CJTXIN,
+    CJFINALTX,
+    CJSIGNFINALTX,
+    CJCOMPLETE,
+    CJSTATUSUPDATE,
+    CJQUEUE,
+    DSEG,
+    DSEGDELTA,
+    SENDMNDELTA,
+    SYNCSTATUSCOUNT,
+    MNGOVERNANCESYNC,
+    MNGOVERNANCEOBJECT,
+    MNGOVERNANCEOBJECTVOTE,
+    MNVERIFY,
+    UNKNOWN, //!< Not a valid message type; also the number of valid ones
+};
+
+/* Get the identifier of a message type, or NetMsgId::UNKNOWN */
+NetMsgId GetNetMsgId(const std::string& command);
+
 /** nServices flags */
 enum ServiceFlags : uint64_t {
     // Nothing
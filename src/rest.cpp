@@ -335,6 +335,37 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
     }
 }
 
+static bool rest_mempool_script(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    if (!fMempoolScriptIndex) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Mempool script index is disabled. Use -mempoolscriptindex to enable it.");
+    }
+    std::string hexScript;
+    const RetFormat rf = ParseDataFormat(hexScript, strURIPart);
+
+    if (hexScript.empty() || !IsHex(hexScript)) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid script: " + hexScript);
+    }
+    const std::vector<unsigned char> scriptData(ParseHex(hexScript));
+    const std::vector<CScript> scripts{CScript(scriptData.begin(), scriptData.end())};
+
+    switch (rf) {
+    case RetFormat::JSON: {
+        UniValue deltas = mempoolScriptIndexToJSON(scripts);
+
+        std::string strJSON = deltas.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+}
+
 static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
 {
     if (!CheckWarmup(req))
@@ -631,6 +662,7 @@ static const struct {
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/info", rest_mempool_info},
       {"/rest/mempool/contents", rest_mempool_contents},
+      {"/rest/mempool/script/", rest_mempool_script},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
@@ -14,6 +14,8 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <hash.h>
+#include <index/addressindex.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <key_io.h>
 #include <policy/feerate.h>
@@ -704,6 +706,328 @@ static UniValue getmempoolentry(const JSONRPCRequest& request)
     return info;
 }
 
+UniValue mempoolScriptIndexToJSON(const std::vector<CScript>& scripts)
+{
+    UniValue result(UniValue::VARR);
+    for (const CScript& script : scripts) {
+        std::vector<std::pair<CMempoolScriptDeltaKey, CMempoolScriptDelta>> entries;
+        mempool.getScriptIndex({script}, entries);
+        for (const auto& entry : entries) {
+            UniValue delta(UniValue::VOBJ);
+            delta.pushKV("script", HexStr(script.begin(), script.end()));
+            delta.pushKV("txid", entry.first.txhash.GetHex());
+            delta.pushKV("index", (int64_t)entry.first.index);
+            delta.pushKV("spending", entry.first.spending);
+            delta.pushKV("amount", ValueFromAmount(entry.second.amount));
+            delta.pushKV("time", entry.second.time);
+            if (entry.first.spending) {
+                delta.pushKV("prevtxid", entry.second.prevout.hash.GetHex());
+                delta.pushKV("prevout", (int64_t)entry.second.prevout.n);
+            }
+            result.push_back(delta);
+        }
+    }
+    return result;
+}
+
+/** Parse a json array of addresses or hex-encoded scriptPubKeys */
+static std::vector<CScript> ParseAddressScripts(const UniValue& addresses)
+{
+    std::vector<CScript> scripts;
+    for (const UniValue& address : addresses.get_array().getValues()) {
+        const std::string& str = address.get_str();
+        CTxDestination dest = DecodeDestination(str);
+        if (IsValidDestination(dest)) {
+            scripts.push_back(GetScriptForDestination(dest));
+        } else if (!str.empty() && IsHex(str)) {
+            std::vector<unsigned char> data(ParseHex(str));
+            scripts.emplace_back(data.begin(), data.end());
+        } else {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script: " + str);
+        }
+    }
+    return scripts;
+}
+
+static UniValue getaddressmempool(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            RPCHelpMan{"getaddressmempool",
+                "\nReturns the mempool outputs paying to and inputs spending from the given addresses or scripts.\n"
+                "Requires -mempoolscriptindex.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of addresses or hex-encoded scriptPubKeys",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "An address or hex-encoded scriptPubKey"},
+                        },
+                    },
+                },
+                RPCResult{
+            "[\n"
+            "  {\n"
+            "    \"script\" : \"hex\",          (string) The scriptPubKey\n"
+            "    \"txid\" : \"hex\",            (string) The mempool transaction id\n"
+            "    \"index\" : n,               (numeric) The output index, or input index when spending\n"
+            "    \"spending\" : true|false,   (boolean) Whether the input spends from the script\n"
+            "    \"amount\" : x.xxx,          (numeric) The amount in " + CURRENCY_UNIT + ", negative when spending\n"
+            "    \"time\" : n,                (numeric) Time the transaction entered the mempool\n"
+            "    \"prevtxid\" : \"hex\",        (string) The spent transaction id, when spending\n"
+            "    \"prevout\" : n              (numeric) The spent output index, when spending\n"
+            "  }, ...\n"
+            "]\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getaddressmempool", "'[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]'")
+            + HelpExampleRpc("getaddressmempool", "[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]")
+                },
+            }.ToString());
+    }
+
+    if (!fMempoolScriptIndex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Mempool script index is disabled, start with -mempoolscriptindex");
+    }
+
+    return mempoolScriptIndexToJSON(ParseAddressScripts(request.params[0]));
+}
+
+static void EnsureAddressIndexSynced()
+{
+    if (!g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is disabled, start with -addressindex");
+    }
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is still syncing with the block chain");
+    }
+}
+
+static UniValue getaddresshistory(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3) {
+        throw std::runtime_error(
+            RPCHelpMan{"getaddresshistory",
+                "\nReturns the confirmed outputs paying to and inputs spending from the given addresses or scripts, ordered by height.\n"
+                "Requires -addressindex.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of addresses or hex-encoded scriptPubKeys",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "An address or hex-encoded scriptPubKey"},
+                        },
+                    },
+                    {"start", RPCArg::Type::NUM, /* default */ "0", "The first block height to include"},
+                    {"end", RPCArg::Type::NUM, /* default */ "the tip height", "The last block height to include"},
+                },
+                RPCResult{
+            "[\n"
+            "  {\n"
+            "    \"script\" : \"hex\",          (string) The scriptPubKey\n"
+            "    \"txid\" : \"hex\",            (string) The transaction id\n"
+            "    \"index\" : n,               (numeric) The output index, or input index when spending\n"
+            "    \"spending\" : true|false,   (boolean) Whether the input spends from the script\n"
+            "    \"height\" : n,              (numeric) The height of the block containing the transaction\n"
+            "    \"amount\" : x.xxx           (numeric) The amount in " + CURRENCY_UNIT + ", negative when spending\n"
+            "  }, ...\n"
+            "]\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getaddresshistory", "'[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]'")
+            + HelpExampleCli("getaddresshistory", "'[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]' 1000 2000")
+            + HelpExampleRpc("getaddresshistory", "[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"], 1000, 2000")
+                },
+            }.ToString());
+    }
+
+    const std::vector<CScript> scripts = ParseAddressScripts(request.params[0]);
+    const int start_height = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    const int end_height = request.params[2].isNull() ? std::numeric_limits<int>::max() : request.params[2].get_int();
+    if (start_height < 0 || end_height < start_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+
+    EnsureAddressIndexSynced();
+
+    std::vector<std::pair<const CScript*, AddressHistoryEntry>> history;
+    for (const CScript& script : scripts) {
+        std::vector<AddressHistoryEntry> entries;
+        if (!g_addressindex->FindHistory(script, start_height, end_height, entries)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+        for (const AddressHistoryEntry& entry : entries) {
+            history.emplace_back(&script, entry);
+        }
+    }
+    std::stable_sort(history.begin(), history.end(), [](const std::pair<const CScript*, AddressHistoryEntry>& a, const std::pair<const CScript*, AddressHistoryEntry>& b) {
+        return a.second.height < b.second.height;
+    });
+
+    UniValue result(UniValue::VARR);
+    for (const auto& item : history) {
+        const AddressHistoryEntry& entry = item.second;
+        UniValue delta(UniValue::VOBJ);
+        delta.pushKV("script", HexStr(item.first->begin(), item.first->end()));
+        delta.pushKV("txid", entry.txid.GetHex());
+        delta.pushKV("index", (int64_t)entry.index);
+        delta.pushKV("spending", entry.spending);
+        delta.pushKV("height", entry.height);
+        delta.pushKV("amount", ValueFromAmount(entry.amount));
+        result.push_back(delta);
+    }
+    return result;
+}
+
+static UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            RPCHelpMan{"getaddressbalance",
+                "\nReturns the confirmed balance of the given addresses or scripts.\n"
+                "Requires -addressindex.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of addresses or hex-encoded scriptPubKeys",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "An address or hex-encoded scriptPubKey"},
+                        },
+                    },
+                },
+                RPCResult{
+            "{\n"
+            "  \"balance\" : x.xxx,         (numeric) The current balance in " + CURRENCY_UNIT + "\n"
+            "  \"received\" : x.xxx         (numeric) The total amount received in " + CURRENCY_UNIT + "\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getaddressbalance", "'[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]'")
+            + HelpExampleRpc("getaddressbalance", "[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]")
+                },
+            }.ToString());
+    }
+
+    const std::vector<CScript> scripts = ParseAddressScripts(request.params[0]);
+
+    EnsureAddressIndexSynced();
+
+    CAmount total_balance = 0;
+    CAmount total_received = 0;
+    for (const CScript& script : scripts) {
+        CAmount balance, received;
+        if (!g_addressindex->FindBalance(script, balance, received)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+        total_balance += balance;
+        total_received += received;
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(total_balance));
+    result.pushKV("received", ValueFromAmount(total_received));
+    return result;
+}
+
+static UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            RPCHelpMan{"getaddressutxos",
+                "\nReturns the confirmed unspent outputs paying to the given addresses or scripts.\n"
+                "Requires -addressindex.\n",
+                {
+                    {"addresses", RPCArg::Type::ARR, RPCArg::Optional::NO, "A json array of addresses or hex-encoded scriptPubKeys",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "An address or hex-encoded scriptPubKey"},
+                        },
+                    },
+                },
+                RPCResult{
+            "[\n"
+            "  {\n"
+            "    \"script\" : \"hex\",          (string) The scriptPubKey\n"
+            "    \"txid\" : \"hex\",            (string) The transaction id\n"
+            "    \"vout\" : n,                (numeric) The output index\n"
+            "    \"amount\" : x.xxx,          (numeric) The amount in " + CURRENCY_UNIT + "\n"
+            "    \"height\" : n               (numeric) The height of the block containing the output\n"
+            "  }, ...\n"
+            "]\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getaddressutxos", "'[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]'")
+            + HelpExampleRpc("getaddressutxos", "[\"CPSSGeFHDnKNxiEyFrD1wcEaHr9hrQDDWc\"]")
+                },
+            }.ToString());
+    }
+
+    const std::vector<CScript> scripts = ParseAddressScripts(request.params[0]);
+
+    EnsureAddressIndexSynced();
+
+    UniValue result(UniValue::VARR);
+    for (const CScript& script : scripts) {
+        std::vector<AddressUnspentEntry> entries;
+        if (!g_addressindex->FindUnspent(script, entries)) {
+            throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to read address index");
+        }
+        for (const AddressUnspentEntry& entry : entries) {
+            UniValue utxo(UniValue::VOBJ);
+            utxo.pushKV("script", HexStr(script.begin(), script.end()));
+            utxo.pushKV("txid", entry.outpoint.hash.GetHex());
+            utxo.pushKV("vout", (int64_t)entry.outpoint.n);
+            utxo.pushKV("amount", ValueFromAmount(entry.amount));
+            utxo.pushKV("height", entry.height);
+            result.push_back(utxo);
+        }
+    }
+    return result;
+}
+
+static UniValue getspentinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 2) {
+        throw std::runtime_error(
+            RPCHelpMan{"getspentinfo",
+                "\nReturns the confirmed input spending the given transaction output.\n"
+                "Requires -spentindex.\n",
+                {
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                    {"n", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number"},
+                },
+                RPCResult{
+            "{\n"
+            "  \"txid\" : \"hex\",            (string) The id of the spending transaction\n"
+            "  \"index\" : n,               (numeric) The input index of the spending transaction\n"
+            "  \"height\" : n               (numeric) The height of the block containing the spending transaction\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getspentinfo", "\"mytxid\" 1")
+            + HelpExampleRpc("getspentinfo", "\"mytxid\", 1")
+                },
+            }.ToString());
+    }
+
+    const uint256 hash(ParseHashV(request.params[0], "txid"));
+    const int n = request.params[1].get_int();
+    if (n < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid output number");
+    }
+
+    if (!g_spentindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent output index is disabled, start with -spentindex");
+    }
+    if (!g_spentindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent output index is still syncing with the block chain");
+    }
+
+    SpentIndexEntry entry;
+    if (!g_spentindex->FindSpender(COutPoint(hash, n), entry)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to find a confirmed spender of the output");
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", entry.txid.GetHex());
+    result.pushKV("index", (int64_t)entry.input_index);
+    result.pushKV("height", entry.height);
+    return result;
+}
+
 static UniValue getblockhash(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -2309,11 +2633,16 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
+    { "blockchain",         "getaddressbalance",      &getaddressbalance,      {"addresses"} },
+    { "blockchain",         "getaddresshistory",      &getaddresshistory,      {"addresses","start","end"} },
+    { "blockchain",         "getaddressmempool",      &getaddressmempool,      {"addresses"} },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"addresses"} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"} },
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
     { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"} },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
+    { "blockchain",         "getspentinfo",           &getspentinfo,           {"txid","n"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
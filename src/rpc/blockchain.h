@@ -11,6 +11,7 @@
 
 class CBlock;
 class CBlockIndex;
+class CScript;
 class UniValue;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
@@ -35,6 +36,9 @@ UniValue mempoolInfoToJSON();
 /** Mempool to JSON */
 UniValue mempoolToJSON(bool fVerbose = false);
 
+/** Mempool script index entries of the given scripts to JSON */
+UniValue mempoolScriptIndexToJSON(const std::vector<CScript>& scripts);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex);
 
@@ -78,6 +78,13 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "sendmany", 8, "cj_level" },
     { "deriveaddresses", 1, "range" },
     { "scantxoutset", 1, "scanobjects" },
+    { "getaddressbalance", 0, "addresses" },
+    { "getaddresshistory", 0, "addresses" },
+    { "getaddresshistory", 1, "start" },
+    { "getaddresshistory", 2, "end" },
+    { "getaddressmempool", 0, "addresses" },
+    { "getaddressutxos", 0, "addresses" },
+    { "getspentinfo", 1, "n" },
     { "addmultisigaddress", 0, "nrequired" },
     { "addmultisigaddress", 1, "keys" },
     { "createmultisig", 0, "nrequired" },
@@ -158,6 +165,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "voteraw", 5, "time" },
     { "logging", 0, "include" },
     { "logging", 1, "exclude" },
+    { "getlockstats", 0, "enable" },
+    { "getlockstats", 1, "reset" },
     { "disconnectnode", 1, "nodeid" },
     // Echo with conversion (For testing only)
     { "echojson", 0, "arg0" },
@@ -616,6 +616,136 @@ UniValue logging(const JSONRPCRequest& request)
     return result;
 }
 
+static void LockStatsToJSON(const LockSiteStats& stats, UniValue& obj)
+{
+    obj.pushKV("acquisitions", stats.acquisitions);
+    obj.pushKV("contentions", stats.contentions);
+    obj.pushKV("wait_total_us", stats.wait_total_us);
+    obj.pushKV("wait_max_us", stats.wait_max_us);
+    obj.pushKV("hold_total_us", stats.hold_total_us);
+    obj.pushKV("hold_max_us", stats.hold_max_us);
+    UniValue histogram(UniValue::VARR);
+    for (int i = 0; i < LOCK_HOLD_BUCKETS; i++) {
+        histogram.push_back(stats.hold_buckets[i]);
+    }
+    obj.pushKV("hold_histogram", histogram);
+}
+
+static UniValue getlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2) {
+        throw std::runtime_error(
+            RPCHelpMan{"getlockstats",
+            "\nReturns how often locks were taken and how long threads waited for and held them, by lock and by LOCK site.\n"
+            "Sites are summed up by the mutex they take. A site taking the mutex of many objects is summed up with the\n"
+            "other sites of its file using the same expression.\n"
+            "Collection is off unless started with -lockstats or enabled here. Only sites taken while collection was on are listed.\n",
+                {
+                    {"enable", RPCArg::Type::BOOL, /* default */ "unchanged", "Turn collection on or off"},
+                    {"reset", RPCArg::Type::BOOL, /* default */ "false", "Zero the counters after returning them"},
+                },
+                RPCResult{
+            "{\n"
+            "  \"enabled\" : true|false,        (boolean) Whether collection is on\n"
+            "  \"locks\" : [                    (array) Locks, by descending total wait time\n"
+            "    {\n"
+            "      \"name\" : \"name\",            (string) The longest expression the lock is taken by, e.g. mempool.cs, followed by a file when ambiguous\n"
+            "      \"acquisitions\" : n,         (numeric) Number of times the lock was taken\n"
+            "      \"contentions\" : n,          (numeric) Number of times the lock was held by another thread\n"
+            "      \"wait_total_us\" : n,        (numeric) Total time spent waiting for the lock\n"
+            "      \"wait_max_us\" : n,          (numeric) Longest wait for the lock\n"
+            "      \"hold_total_us\" : n,        (numeric) Total time the lock was held\n"
+            "      \"hold_max_us\" : n,          (numeric) Longest time the lock was held\n"
+            "      \"hold_histogram\" : [n,...], (array) Hold times below 1us, 10us, 100us, 1ms, 10ms, 100ms, 1s, and longer\n"
+            "      \"sites\" : [                 (array) The same counters for each LOCK statement\n"
+            "        {\n"
+            "          \"location\" : \"file:line\",\n"
+            "          ...\n"
+            "        }, ...\n"
+            "      ]\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getlockstats", "true")
+            + HelpExampleCli("getlockstats", "")
+            + HelpExampleRpc("getlockstats", "true, false")
+                },
+            }.ToString());
+    }
+
+    if (!request.params[0].isNull()) {
+        g_lock_stats_enabled = request.params[0].get_bool();
+    }
+
+    // Sum the sites of each mutex, or of each expression and file for sites taking
+    // several instances; sites are listed by descending wait time.
+    std::vector<LockSiteStats> sites = GetLockStats();
+    std::sort(sites.begin(), sites.end(), [](const LockSiteStats& a, const LockSiteStats& b) {
+        return a.wait_total_us > b.wait_total_us;
+    });
+    std::map<std::pair<const void*, std::string>, std::pair<LockSiteStats, UniValue>> locks;
+    for (const LockSiteStats& site : sites) {
+        const auto key = site.mutex ? std::make_pair(site.mutex, std::string()) : std::make_pair((const void*)nullptr, site.name + "@" + site.file);
+        auto it = locks.find(key);
+        if (it == locks.end()) {
+            it = locks.emplace(key, std::make_pair(LockSiteStats(), UniValue(UniValue::VARR))).first;
+            it->second.first.name = site.name;
+            it->second.first.file = site.file;
+        }
+        LockSiteStats& total = it->second.first;
+        // the longest expression is the most qualified one, e.g. mempool.cs over cs
+        if (site.name.size() > total.name.size()) {
+            total.name = site.name;
+            total.file = site.file;
+        }
+        total.acquisitions += site.acquisitions;
+        total.contentions += site.contentions;
+        total.wait_total_us += site.wait_total_us;
+        total.wait_max_us = std::max(total.wait_max_us, site.wait_max_us);
+        total.hold_total_us += site.hold_total_us;
+        total.hold_max_us = std::max(total.hold_max_us, site.hold_max_us);
+        for (int i = 0; i < LOCK_HOLD_BUCKETS; i++) {
+            total.hold_buckets[i] += site.hold_buckets[i];
+        }
+
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("location", strprintf("%s:%d", site.file, site.line));
+        LockStatsToJSON(site, obj);
+        it->second.second.push_back(obj);
+    }
+
+    std::map<std::string, int> name_count;
+    std::vector<const std::pair<LockSiteStats, UniValue>*> sorted;
+    for (const auto& lock : locks) {
+        name_count[lock.second.first.name]++;
+        sorted.push_back(&lock.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<LockSiteStats, UniValue>* a, const std::pair<LockSiteStats, UniValue>* b) {
+        return a->first.wait_total_us > b->first.wait_total_us;
+    });
+
+    UniValue lock_list(UniValue::VARR);
+    for (const auto* lock : sorted) {
+        UniValue obj(UniValue::VOBJ);
+        const LockSiteStats& total = lock->first;
+        obj.pushKV("name", name_count[total.name] > 1 ? strprintf("%s (%s)", total.name, fs::path(total.file).filename().string()) : total.name);
+        LockStatsToJSON(lock->first, obj);
+        obj.pushKV("sites", lock->second);
+        lock_list.push_back(obj);
+    }
+
+    if (!request.params[1].isNull() && request.params[1].get_bool()) {
+        ResetLockStats();
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("enabled", g_lock_stats_enabled.load());
+    result.pushKV("locks", lock_list);
+    return result;
+}
+
 static UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -639,6 +769,7 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
+    { "control",            "getlockstats",           &getlockstats,           {"enable", "reset"}},
     { "util",               "validateaddress",        &validateaddress,        {"address"} },
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys","address_type"} },
     { "util",               "deriveaddresses",        &deriveaddresses,        {"descriptor", "range"} },
@@ -123,6 +123,18 @@ static UniValue getpeerinfo(const JSONRPCRequest& request)
             "                               When a message type is not listed in this json object, the bytes received are 0.\n"
             "                               Only known message types can appear as keys in the object and all bytes received of unknown message types are listed under '"+NET_MESSAGE_COMMAND_OTHER+"'.\n"
             "       ...\n"
+            "    },\n"
+            "    \"msgssent_per_msg\": {\n"
+            "       \"msg\": n,               (numeric) The number of messages sent aggregated by message type\n"
+            "       ...\n"
+            "    },\n"
+            "    \"msgsrecv_per_msg\": {\n"
+            "       \"msg\": n,               (numeric) The number of messages received aggregated by message type\n"
+            "       ...\n"
+            "    },\n"
+            "    \"processtime_per_msg\": {\n"
+            "       \"msg\": n,               (numeric) The time in seconds spent processing received messages aggregated by message type\n"
+            "       ...\n"
             "    }\n"
             "  }\n"
             "  ,...\n"
@@ -201,6 +213,27 @@ static UniValue getpeerinfo(const JSONRPCRequest& request)
         }
         obj.pushKV("bytesrecv_per_msg", recvPerMsgCmd);
 
+        UniValue sendMsgsPerMsgCmd(UniValue::VOBJ);
+        for (const auto& i : stats.mapSendMsgsPerMsgCmd) {
+            if (i.second > 0)
+                sendMsgsPerMsgCmd.pushKV(i.first, i.second);
+        }
+        obj.pushKV("msgssent_per_msg", sendMsgsPerMsgCmd);
+
+        UniValue recvMsgsPerMsgCmd(UniValue::VOBJ);
+        for (const auto& i : stats.mapRecvMsgsPerMsgCmd) {
+            if (i.second > 0)
+                recvMsgsPerMsgCmd.pushKV(i.first, i.second);
+        }
+        obj.pushKV("msgsrecv_per_msg", recvMsgsPerMsgCmd);
+
+        UniValue processTimePerMsgCmd(UniValue::VOBJ);
+        for (const auto& i : stats.mapProcessTimePerMsgCmd) {
+            if (i.second > 0)
+                processTimePerMsgCmd.pushKV(i.first, i.second * 0.000001);
+        }
+        obj.pushKV("processtime_per_msg", processTimePerMsgCmd);
+
         ret.push_back(obj);
     }
 
@@ -421,6 +454,52 @@ static UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue getmsgstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+            RPCHelpMan{"getmsgstats",
+                "\nReturns network traffic and processing time per message type, over all peers since startup.\n"
+                "Messages of unknown types are listed under '"+NET_MESSAGE_COMMAND_OTHER+"'.\n",
+                {},
+                RPCResult{
+            "{\n"
+            "  \"msg\": {                 (json object) A message type with any traffic\n"
+            "    \"msgsrecv\": n,         (numeric) Messages received\n"
+            "    \"bytesrecv\": n,        (numeric) Bytes received, including headers\n"
+            "    \"msgssent\": n,         (numeric) Messages sent\n"
+            "    \"bytessent\": n,        (numeric) Bytes sent, including headers\n"
+            "    \"processtime\": n,      (numeric) Total time in seconds spent processing received messages\n"
+            "    \"avgprocesstime\": n    (numeric) Average time in seconds spent processing a received message\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+                },
+                RPCExamples{
+                    HelpExampleCli("getmsgstats", "")
+            + HelpExampleRpc("getmsgstats", "")
+                },
+            }.ToString());
+    if(!g_connman)
+        throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
+
+    UniValue ret(UniValue::VOBJ);
+    for (const auto& i : g_connman->GetMsgStats()) {
+        const CMsgCmdStats& stats = i.second;
+        if (stats.nRecvMsgs == 0 && stats.nSendMsgs == 0)
+            continue;
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("msgsrecv", stats.nRecvMsgs);
+        obj.pushKV("bytesrecv", stats.nRecvBytes);
+        obj.pushKV("msgssent", stats.nSendMsgs);
+        obj.pushKV("bytessent", stats.nSendBytes);
+        obj.pushKV("processtime", stats.nProcessTime * 0.000001);
+        obj.pushKV("avgprocesstime", stats.nRecvMsgs ? stats.nProcessTime * 0.000001 / stats.nRecvMsgs : 0.0);
+        ret.pushKV(i.first, obj);
+    }
+    return ret;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -749,6 +828,7 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         {"address", "nodeid"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       {"node"} },
     { "network",            "getnettotals",           &getnettotals,           {} },
+    { "network",            "getmsgstats",            &getmsgstats,            {} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         {} },
     { "network",            "setban",                 &setban,                 {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             {} },
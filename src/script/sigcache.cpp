@@ -11,54 +11,78 @@
 #include <uint256.h>
 #include <util/system.h>
 
-#include <cuckoocache.h>
-#include <boost/thread.hpp>
+CSignatureCache::CSignatureCache()
+{
+    GetRandBytes(nonce.begin(), 32);
+}
 
-namespace {
-/**
- * Valid signature cache, to avoid doing expensive ECDSA signature checking
- * twice for every transaction (once when accepted into memory pool, and
- * again when accepted into the block chain)
- */
-class CSignatureCache
-{
-private:
-     //! Entries are SHA256(nonce || signature hash || public key || signature):
-    uint256 nonce;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
-
-public:
-    CSignatureCache()
-    {
-        GetRandBytes(nonce.begin(), 32);
-    }
+CSignatureCache::Shard& CSignatureCache::GetShard(const uint256& entry) const
+{
+    // The cuckoo cache maps the hashes to buckets by their high bits, so
+    // the low bits of the first one are free to select the shard.
+    uint32_t u;
+    std::memcpy(&u, entry.begin(), 4);
+    return *shards[u & (shards.size() - 1)];
+}
+
+void CSignatureCache::ComputeEntry(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const
+{
+    CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+}
 
-    void
-    ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+bool CSignatureCache::Get(const uint256& entry, const bool erase)
+{
+    Shard& shard = GetShard(entry);
+    bool found;
     {
-        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+        boost::shared_lock<boost::shared_mutex> lock(shard.cs_shard);
+        found = shard.setValid.contains(entry, erase);
     }
+    (found ? shard.nHits : shard.nMisses).fetch_add(1, std::memory_order_relaxed);
+    return found;
+}
 
-    bool
-    Get(const uint256& entry, const bool erase)
-    {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+void CSignatureCache::Set(const uint256& entry)
+{
+    Shard& shard = GetShard(entry);
+    boost::unique_lock<boost::shared_mutex> lock(shard.cs_shard);
+    shard.setValid.insert(entry);
+}
+
+size_t CSignatureCache::Setup(size_t nBytes, size_t nShards)
+{
+    nShards = std::max<size_t>(1, std::min<size_t>(nShards, MAX_SIGCACHE_SHARDS));
+    while (nShards & (nShards - 1)) {
+        nShards &= nShards - 1;
+    }
+    shards.clear();
+    size_t nElems = 0;
+    for (size_t i = 0; i < nShards; ++i) {
+        shards.emplace_back(new Shard());
+        nElems += shards.back()->setValid.setup_bytes(nBytes / nShards);
     }
+    return nElems;
+}
 
-    void Set(uint256& entry)
-    {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+uint64_t CSignatureCache::GetHits() const
+{
+    uint64_t nHits = 0;
+    for (const auto& shard : shards) {
+        nHits += shard->nHits.load(std::memory_order_relaxed);
     }
-    uint32_t setup_bytes(size_t n)
-    {
-        return setValid.setup_bytes(n);
+    return nHits;
+}
+
+uint64_t CSignatureCache::GetMisses() const
+{
+    uint64_t nMisses = 0;
+    for (const auto& shard : shards) {
+        nMisses += shard->nMisses.load(std::memory_order_relaxed);
     }
-};
+    return nMisses;
+}
 
+namespace {
 /* In previous versions of this code, signatureCache was a local static variable
  * in CachingTransactionSignatureChecker::VerifySignature.  We initialize
  * signatureCache outside of VerifySignature to avoid the atomic operation per
@@ -66,6 +90,7 @@ public:
  * signatureCache could be made local to VerifySignature.
 */
 static CSignatureCache signatureCache;
+static CSignatureCache messageSignatureCache;
 } // namespace
 
 // To be called once in AppInitMain/BasicTestingSetup to initialize the
@@ -73,11 +98,50 @@ static CSignatureCache signatureCache;
 void InitSignatureCache()
 {
     // nMaxCacheSize is unsigned. If -maxsigcachesize is set to zero,
-    // setup_bytes creates the minimum possible cache (2 elements).
+    // setup_bytes creates the minimum possible cache (2 elements per shard).
     size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE) / 2), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
-    size_t nElems = signatureCache.setup_bytes(nMaxCacheSize);
-    LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache, able to store %zu elements\n",
-            (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
+    size_t nShards = std::max((int64_t)1, gArgs.GetArg("-sigcacheshards", DEFAULT_SIGCACHE_SHARDS));
+    size_t nElems = signatureCache.Setup(nMaxCacheSize, nShards);
+    LogPrintf("Using %zu MiB out of %zu/2 requested for signature cache in %zu shards, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, signatureCache.GetShardCount(), nElems);
+
+    nElems = messageSignatureCache.Setup(MESSAGE_SIG_CACHE_SIZE << 20, nShards);
+    LogPrintf("Using %zu MiB for message signature cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nElems);
+}
+
+uint64_t GetSignatureCacheHits()
+{
+    return signatureCache.GetHits();
+}
+
+uint64_t GetSignatureCacheMisses()
+{
+    return signatureCache.GetMisses();
+}
+
+bool IsMessageSignatureCached(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+{
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, vchSig, pubkey);
+    return messageSignatureCache.Get(entry, false);
+}
+
+void CacheMessageSignature(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+{
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, vchSig, pubkey);
+    messageSignatureCache.Set(entry);
+}
+
+uint64_t GetMessageSignatureCacheHits()
+{
+    return messageSignatureCache.GetHits();
+}
+
+uint64_t GetMessageSignatureCacheMisses()
+{
+    return messageSignatureCache.GetMisses();
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
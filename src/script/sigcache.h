@@ -6,16 +6,26 @@
 #ifndef BITCOIN_SCRIPT_SIGCACHE_H
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
+#include <cuckoocache.h>
 #include <script/interpreter.h>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
+
 // DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
 // systems). Due to how we count cache size, actual memory usage is slightly
 // more (~32.25 MB)
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+// Size of the cache of verified network message signatures, in MiB
+static const unsigned int MESSAGE_SIG_CACHE_SIZE = 4;
+// Number of independently locked parts of the signature cache
+static const unsigned int DEFAULT_SIGCACHE_SHARDS = 16;
+static const unsigned int MAX_SIGCACHE_SHARDS = 256;
 
 class CPubKey;
 
@@ -40,6 +50,54 @@ public:
     }
 };
 
+/**
+ * Valid signature cache, to avoid doing expensive ECDSA signature checking
+ * twice for every transaction (once when accepted into memory pool, and
+ * again when accepted into the block chain)
+ *
+ * Entries are spread over shards that each have their own lock, so that
+ * the script check threads, mempool acceptance and message verification
+ * rarely wait on each other.
+ */
+class CSignatureCache
+{
+private:
+    struct Shard
+    {
+        CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+        boost::shared_mutex cs_shard;
+        std::atomic<uint64_t> nHits{0};
+        std::atomic<uint64_t> nMisses{0};
+    };
+
+    //! Entries are SHA256(nonce || signature hash || public key || signature):
+    uint256 nonce;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    Shard& GetShard(const uint256& entry) const;
+
+public:
+    CSignatureCache();
+
+    void ComputeEntry(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const;
+
+    bool Get(const uint256& entry, const bool erase);
+    void Set(const uint256& entry);
+
+    /**
+     * Split the cache into nShards shards (rounded down to a power of two)
+     * sharing at most nBytes of memory. Must be called before use, and not
+     * concurrently with any other method.
+     *
+     * @returns the number of entries the cache can hold
+     */
+    size_t Setup(size_t nBytes, size_t nShards);
+
+    size_t GetShardCount() const { return shards.size(); }
+    uint64_t GetHits() const;
+    uint64_t GetMisses() const;
+};
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
@@ -53,4 +111,19 @@ public:
 
 void InitSignatureCache();
 
+/** Lookups of transaction signatures found in, and missing from, the signature cache */
+uint64_t GetSignatureCacheHits();
+uint64_t GetSignatureCacheMisses();
+
+/**
+ * Compact signatures of network messages (masternode broadcasts and pings,
+ * payment and funding votes, CoinJoin queues and broadcast transactions)
+ * found valid for a hash and public key. The same objects arrive from every
+ * peer, so a relayed duplicate costs a lookup instead of a key recovery.
+ */
+bool IsMessageSignatureCached(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey);
+void CacheMessageSignature(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey);
+uint64_t GetMessageSignatureCacheHits();
+uint64_t GetMessageSignatureCacheMisses();
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 
+#include <chrono>
 #include <map>
 #include <memory>
 #include <set>
@@ -24,6 +25,101 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+std::atomic<bool> g_lock_stats_enabled{DEFAULT_LOCKSTATS};
+
+//! Head of the intrusive list of lock sites that recorded an acquisition
+static std::atomic<LockSite*> g_lock_sites{nullptr};
+
+//! Stored as the mutex of a site that took more than one
+static const char g_many_mutexes = 0;
+
+static void UpdateMax(std::atomic<uint64_t>& max, uint64_t value)
+{
+    uint64_t prev = max.load(std::memory_order_relaxed);
+    while (prev < value && !max.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+}
+
+int64_t LockStatsTimeMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LockSite::RecordAcquire(const void* mutex_in, bool contended, int64_t wait_us)
+{
+    const void* prev = mutex.load(std::memory_order_relaxed);
+    if (prev != mutex_in && prev != &g_many_mutexes) {
+        if (prev != nullptr || (!mutex.compare_exchange_strong(prev, mutex_in, std::memory_order_relaxed) && prev != mutex_in)) {
+            mutex.store(&g_many_mutexes, std::memory_order_relaxed);
+        }
+    }
+
+    if (!registered.exchange(true)) {
+        // Sites are static and never unlinked, so a plain push is enough.
+        LockSite* head = g_lock_sites.load();
+        do {
+            next = head;
+        } while (!g_lock_sites.compare_exchange_weak(head, this));
+    }
+
+    acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (contended) {
+        contentions.fetch_add(1, std::memory_order_relaxed);
+        wait_total_us.fetch_add(wait_us, std::memory_order_relaxed);
+        UpdateMax(wait_max_us, wait_us);
+    }
+}
+
+void LockSite::RecordRelease(int64_t hold_us)
+{
+    hold_total_us.fetch_add(hold_us, std::memory_order_relaxed);
+    UpdateMax(hold_max_us, hold_us);
+
+    int bucket = 0;
+    for (int64_t limit = 1; bucket < LOCK_HOLD_BUCKETS - 1 && hold_us >= limit; limit *= 10) {
+        bucket++;
+    }
+    hold_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<LockSiteStats> GetLockStats()
+{
+    std::vector<LockSiteStats> result;
+    for (const LockSite* site = g_lock_sites.load(); site; site = site->next) {
+        LockSiteStats stats;
+        stats.name = site->name;
+        stats.file = site->file;
+        stats.line = site->line;
+        const void* mutex = site->mutex.load(std::memory_order_relaxed);
+        stats.mutex = mutex != &g_many_mutexes ? mutex : nullptr;
+        stats.acquisitions = site->acquisitions.load(std::memory_order_relaxed);
+        stats.contentions = site->contentions.load(std::memory_order_relaxed);
+        stats.wait_total_us = site->wait_total_us.load(std::memory_order_relaxed);
+        stats.wait_max_us = site->wait_max_us.load(std::memory_order_relaxed);
+        stats.hold_total_us = site->hold_total_us.load(std::memory_order_relaxed);
+        stats.hold_max_us = site->hold_max_us.load(std::memory_order_relaxed);
+        for (int i = 0; i < LOCK_HOLD_BUCKETS; i++) {
+            stats.hold_buckets[i] = site->hold_buckets[i].load(std::memory_order_relaxed);
+        }
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+void ResetLockStats()
+{
+    for (LockSite* site = g_lock_sites.load(); site; site = site->next) {
+        site->acquisitions = 0;
+        site->contentions = 0;
+        site->wait_total_us = 0;
+        site->wait_max_us = 0;
+        site->hold_total_us = 0;
+        site->hold_max_us = 0;
+        for (int i = 0; i < LOCK_HOLD_BUCKETS; i++) {
+            site->hold_buckets[i] = 0;
+        }
+    }
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
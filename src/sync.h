@@ -8,9 +8,13 @@
 
 #include <threadsafety.h>
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <string>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 
 ////////////////////////////////////////////////
@@ -114,14 +118,87 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+static const bool DEFAULT_LOCKSTATS = false;
+
+/** Whether LOCK sites record contention statistics. Off by default (-lockstats). */
+extern std::atomic<bool> g_lock_stats_enabled;
+
+/** Number of buckets of the lock hold time histogram, by powers of ten of microseconds. */
+static constexpr int LOCK_HOLD_BUCKETS = 8;
+
+/**
+ * Contention counters of a single LOCK/LOCK2/TRY_LOCK statement. Each site is
+ * a static object, so recording needs no lookup, and joins the list returned
+ * by GetLockStats() the first time it records anything.
+ */
+struct LockSite
+{
+    const char* const name;
+    const char* const file;
+    const int line;
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contentions{0};
+    std::atomic<uint64_t> wait_total_us{0};
+    std::atomic<uint64_t> wait_max_us{0};
+    std::atomic<uint64_t> hold_total_us{0};
+    std::atomic<uint64_t> hold_max_us{0};
+    std::atomic<uint64_t> hold_buckets[LOCK_HOLD_BUCKETS] = {};
+
+    //! The mutex taken here, so that sites naming it differently can be summed up
+    std::atomic<const void*> mutex{nullptr};
+
+    std::atomic<bool> registered{false};
+    LockSite* next = nullptr;
+
+    constexpr LockSite(const char* name_in, const char* file_in, int line_in) : name(name_in), file(file_in), line(line_in) {}
+
+    void RecordAcquire(const void* mutex_in, bool contended, int64_t wait_us);
+    void RecordRelease(int64_t hold_us);
+};
+
+/** Copy of the counters of a LockSite. */
+struct LockSiteStats
+{
+    std::string name;
+    std::string file;
+    int line;
+    //! The mutex taken at the site, or nullptr if it took several instances (e.g. a member lock of many objects)
+    const void* mutex;
+    uint64_t acquisitions;
+    uint64_t contentions;
+    uint64_t wait_total_us;
+    uint64_t wait_max_us;
+    uint64_t hold_total_us;
+    uint64_t hold_max_us;
+    uint64_t hold_buckets[LOCK_HOLD_BUCKETS];
+};
+
+/** Microseconds on a steady clock, for lock timings. */
+int64_t LockStatsTimeMicros();
+
+/** Return the counters of every lock site that recorded an acquisition. */
+std::vector<LockSiteStats> GetLockStats();
+
+/** Zero the counters of every lock site. */
+void ResetLockStats();
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base
 {
 private:
+    LockSite* m_site = nullptr;
+    //! When the lock was taken, if the acquisition was recorded in m_site
+    int64_t m_hold_start = 0;
+
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()));
+        if (m_site && g_lock_stats_enabled.load(std::memory_order_relaxed)) {
+            EnterProfiled(pszName, pszFile, nLine);
+            return;
+        }
 #ifdef DEBUG_LOCKCONTENTION
         if (!Base::try_lock()) {
             PrintLockContention(pszName, pszFile, nLine);
@@ -132,17 +209,35 @@ private:
 #endif
     }
 
+    void EnterProfiled(const char* pszName, const char* pszFile, int nLine)
+    {
+        const int64_t start = LockStatsTimeMicros();
+        const bool contended = !Base::try_lock();
+        if (contended) {
+#ifdef DEBUG_LOCKCONTENTION
+            PrintLockContention(pszName, pszFile, nLine);
+#endif
+            Base::lock();
+        }
+        m_hold_start = LockStatsTimeMicros();
+        m_site->RecordAcquire((void*)(Base::mutex()), contended, m_hold_start - start);
+    }
+
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()), true);
         Base::try_lock();
         if (!Base::owns_lock())
             LeaveCritical();
+        else if (m_site && g_lock_stats_enabled.load(std::memory_order_relaxed)) {
+            m_hold_start = LockStatsTimeMicros();
+            m_site->RecordAcquire((void*)(Base::mutex()), false, 0);
+        }
         return Base::owns_lock();
     }
 
 public:
-    UniqueLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : Base(mutexIn, std::defer_lock)
+    UniqueLock(Mutex& mutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false, LockSite* site = nullptr) EXCLUSIVE_LOCK_FUNCTION(mutexIn) : Base(mutexIn, std::defer_lock), m_site(site)
     {
         if (fTry)
             TryEnter(pszName, pszFile, nLine);
@@ -150,7 +245,7 @@ public:
             Enter(pszName, pszFile, nLine);
     }
 
-    UniqueLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false) EXCLUSIVE_LOCK_FUNCTION(pmutexIn)
+    UniqueLock(Mutex* pmutexIn, const char* pszName, const char* pszFile, int nLine, bool fTry = false, LockSite* site = nullptr) EXCLUSIVE_LOCK_FUNCTION(pmutexIn) : m_site(site)
     {
         if (!pmutexIn) return;
 
@@ -163,8 +258,10 @@ public:
 
     ~UniqueLock() UNLOCK_FUNCTION()
     {
-        if (Base::owns_lock())
+        if (Base::owns_lock()) {
             LeaveCritical();
+            if (m_hold_start) m_site->RecordRelease(LockStatsTimeMicros() - m_hold_start);
+        }
     }
 
     operator bool()
@@ -179,11 +276,14 @@ using DebugLock = UniqueLock<typename std::remove_reference<typename std::remove
 #define PASTE(x, y) x ## y
 #define PASTE2(x, y) PASTE(x, y)
 
-#define LOCK(cs) DebugLock<decltype(cs)> PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__)
+//! The LockSite of the enclosing lock statement; the lambda gives every expansion its own static.
+#define LOCK_SITE(name) ([]() -> LockSite* { static LockSite site(name, __FILE__, __LINE__); return &site; }())
+
+#define LOCK(cs) DebugLock<decltype(cs)> PASTE2(criticalblock, __COUNTER__)(cs, #cs, __FILE__, __LINE__, false, LOCK_SITE(#cs))
 #define LOCK2(cs1, cs2)                                               \
-    DebugLock<decltype(cs1)> criticalblock1(cs1, #cs1, __FILE__, __LINE__); \
-    DebugLock<decltype(cs2)> criticalblock2(cs2, #cs2, __FILE__, __LINE__);
-#define TRY_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__, true)
+    DebugLock<decltype(cs1)> criticalblock1(cs1, #cs1, __FILE__, __LINE__, false, LOCK_SITE(#cs1)); \
+    DebugLock<decltype(cs2)> criticalblock2(cs2, #cs2, __FILE__, __LINE__, false, LOCK_SITE(#cs2));
+#define TRY_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__, true, LOCK_SITE(#cs))
 #define WAIT_LOCK(cs, name) DebugLock<decltype(cs)> name(cs, #cs, __FILE__, __LINE__)
 
 #define ENTER_CRITICAL_SECTION(cs)                            \
@@ -0,0 +1,147 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/addressindex.h>
+#include <miner.h>
+#include <pow.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/test_chaincoin.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+static void WaitForSync(AddressIndex& addressindex)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!addressindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_initial_sync, TestChain100Setup)
+{
+    AddressIndex addressindex(1 << 20, true);
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const CScript payee_script = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+
+    CAmount balance, received;
+    BOOST_CHECK(addressindex.FindBalance(coinbase_script, balance, received));
+    BOOST_CHECK_EQUAL(received, 0);
+
+    // BlockUntilSyncedToCurrentChain should return false before addressindex is started.
+    BOOST_CHECK(!addressindex.BlockUntilSyncedToCurrentChain());
+
+    addressindex.Start();
+    WaitForSync(addressindex);
+
+    // The index has every coinbase output of the chain it synced from.
+    CAmount coinbase_total = 0;
+    for (const auto& txn : m_coinbase_txns) {
+        for (const CTxOut& out : txn->vout) {
+            if (out.scriptPubKey == coinbase_script) coinbase_total += out.nValue;
+        }
+    }
+    BOOST_CHECK(addressindex.FindBalance(coinbase_script, balance, received));
+    BOOST_CHECK_EQUAL(balance, coinbase_total);
+    BOOST_CHECK_EQUAL(received, coinbase_total);
+
+    std::vector<AddressUnspentEntry> unspent;
+    BOOST_CHECK(addressindex.FindUnspent(coinbase_script, unspent));
+    BOOST_CHECK_EQUAL(unspent.size(), m_coinbase_txns.size());
+
+    std::vector<AddressHistoryEntry> history;
+    BOOST_CHECK(addressindex.FindHistory(coinbase_script, 10, 19, history));
+    BOOST_CHECK_EQUAL(history.size(), 10U);
+    for (size_t i = 0; i < history.size(); i++) {
+        BOOST_CHECK_EQUAL(history[i].height, 10 + (int)i);
+        BOOST_CHECK(history[i].txid == m_coinbase_txns[9 + i]->GetHash());
+        BOOST_CHECK(!history[i].spending);
+    }
+
+    // Spend the first coinbase to a P2PKH script in a new block.
+    const CTransactionRef& spent = m_coinbase_txns[0];
+    CMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(spent->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = spent->vout[0].nValue - CENT;
+    spend.vout[0].scriptPubKey = payee_script;
+    std::vector<unsigned char> sig;
+    uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+
+    const CBlock block = MineBlock({spend}, coinbase_script);
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+    const int spend_height = m_coinbase_txns.size() + 1;
+
+    history.clear();
+    BOOST_CHECK(addressindex.FindHistory(coinbase_script, spend_height, spend_height, history));
+    BOOST_CHECK_EQUAL(history.size(), 2U);
+    bool found_spend = false;
+    for (const AddressHistoryEntry& entry : history) {
+        if (entry.spending) {
+            found_spend = true;
+            BOOST_CHECK(entry.txid == spend.GetHash());
+            BOOST_CHECK_EQUAL(entry.amount, -spent->vout[0].nValue);
+        }
+    }
+    BOOST_CHECK(found_spend);
+
+    BOOST_CHECK(addressindex.FindBalance(payee_script, balance, received));
+    BOOST_CHECK_EQUAL(balance, spend.vout[0].nValue);
+    unspent.clear();
+    BOOST_CHECK(addressindex.FindUnspent(payee_script, unspent));
+    BOOST_CHECK_EQUAL(unspent.size(), 1U);
+    BOOST_CHECK(unspent[0].outpoint == COutPoint(spend.GetHash(), 0));
+    BOOST_CHECK_EQUAL(unspent[0].height, spend_height);
+
+    // Replace the spending block: the index rewinds it before connecting the new tip.
+    {
+        CValidationState state;
+        CBlockIndex* pindex;
+        {
+            LOCK(cs_main);
+            pindex = LookupBlockIndex(block.GetHash());
+        }
+        BOOST_REQUIRE(InvalidateBlock(state, Params(), pindex));
+        BOOST_REQUIRE(ActivateBestChain(state, Params()));
+    }
+    // The spend was returned to the mempool; drop it so the template's coinbase
+    // does not claim its fee.
+    mempool.clear();
+    MineBlock({}, coinbase_script);
+    BOOST_CHECK(addressindex.BlockUntilSyncedToCurrentChain());
+
+    BOOST_CHECK(addressindex.FindBalance(payee_script, balance, received));
+    BOOST_CHECK_EQUAL(balance, 0);
+    BOOST_CHECK_EQUAL(received, 0);
+    unspent.clear();
+    BOOST_CHECK(addressindex.FindUnspent(coinbase_script, unspent));
+    BOOST_CHECK_EQUAL(unspent.size(), m_coinbase_txns.size() + 1);
+    history.clear();
+    BOOST_CHECK(addressindex.FindHistory(coinbase_script, spend_height, spend_height, history));
+    BOOST_CHECK_EQUAL(history.size(), 1U);
+    BOOST_CHECK(!history[0].spending);
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    addressindex.Stop();
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+
+    // Rest of shutdown sequence and destructors happen in ~TestingSetup()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
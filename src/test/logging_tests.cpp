@@ -0,0 +1,124 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <fs.h>
+#include <logging.h>
+#include <test/test_chaincoin.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(logging_tests, BasicTestingSetup)
+
+static std::vector<std::string> ReadLines(const fs::path& path)
+{
+    std::vector<std::string> lines;
+    fsbridge::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_order)
+{
+    BCLog::Logger logger;
+    logger.m_print_to_file = true;
+    logger.m_log_timestamps = false;
+    logger.m_file_path = SetDataDir("logging_async_order") / "debug.log";
+    BOOST_REQUIRE(logger.OpenDebugLog());
+
+    logger.LogPrintStr("before\n");
+    logger.StartAsyncLogging(1024);
+    for (int i = 0; i < 1000; i++) {
+        logger.LogPrintStr(strprintf("message %d\n", i));
+    }
+    logger.StopAsyncLogging();
+    logger.LogPrintStr("after\n");
+
+    const std::vector<std::string> lines = ReadLines(logger.m_file_path);
+    BOOST_REQUIRE_EQUAL(lines.size(), 1002U);
+    BOOST_CHECK_EQUAL(lines.front(), "before");
+    for (int i = 0; i < 1000; i++) {
+        BOOST_CHECK_EQUAL(lines[i + 1], strprintf("message %d", i));
+    }
+    BOOST_CHECK_EQUAL(lines.back(), "after");
+    BOOST_CHECK_EQUAL(logger.GetDroppedMessages(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_wakeup)
+{
+    BCLog::Logger logger;
+    logger.m_print_to_file = true;
+    logger.m_log_timestamps = false;
+    logger.m_file_path = SetDataDir("logging_async_wakeup") / "debug.log";
+    BOOST_REQUIRE(logger.OpenDebugLog());
+
+    // The writer sleeps until a message arrives in the empty queue, and
+    // then writes it without waiting for more.
+    logger.StartAsyncLogging(1024);
+    for (int i = 0; i < 3; i++) {
+        logger.LogPrintStr(strprintf("message %d\n", i));
+        size_t lines = 0;
+        for (int wait = 0; wait < 1000 && lines <= (size_t)i; wait++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            lines = ReadLines(logger.m_file_path).size();
+        }
+        BOOST_CHECK_EQUAL(lines, (size_t)i + 1);
+    }
+    logger.StopAsyncLogging();
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_overflow)
+{
+    BCLog::Logger logger;
+    logger.m_print_to_file = true;
+    logger.m_log_timestamps = false;
+    logger.m_file_path = SetDataDir("logging_async_overflow") / "debug.log";
+    BOOST_REQUIRE(logger.OpenDebugLog());
+
+    // Several threads overrun a small buffer: every message is either
+    // written once or counted as dropped.
+    constexpr int n_threads = 4;
+    constexpr int n_messages = 10000;
+    logger.StartAsyncLogging(16);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&logger, t] {
+            for (int i = 0; i < n_messages; i++) {
+                logger.LogPrintStr(strprintf("thread %d message %d\n", t, i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    logger.StopAsyncLogging();
+
+    uint64_t written = 0;
+    uint64_t reported_dropped = 0;
+    std::vector<int> last_message(n_threads, -1);
+    for (const std::string& line : ReadLines(logger.m_file_path)) {
+        int t, i;
+        unsigned long dropped;
+        if (sscanf(line.c_str(), "thread %d message %d", &t, &i) == 2) {
+            // Messages of one thread keep their order.
+            BOOST_CHECK(i > last_message[t]);
+            last_message[t] = i;
+            written++;
+        } else if (sscanf(line.c_str(), "%lu log messages dropped", &dropped) == 1) {
+            reported_dropped += dropped;
+        } else {
+            BOOST_ERROR("unexpected log line: " + line);
+        }
+    }
+    BOOST_CHECK_EQUAL(reported_dropped, logger.GetDroppedMessages());
+    BOOST_CHECK_EQUAL(written + reported_dropped, (uint64_t)n_threads * n_messages);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
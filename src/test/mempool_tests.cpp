@@ -5,6 +5,7 @@
 #include <policy/policy.h>
 #include <txmempool.h>
 #include <util/system.h>
+#include <validation.h>
 
 #include <test/test_chaincoin.h>
 
@@ -590,6 +591,39 @@ inline CTransactionRef make_tx(std::vector<CAmount>&& output_values, std::vector
 }
 
 
+BOOST_AUTO_TEST_CASE(MempoolBulkTrimTest)
+{
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    // Independent transactions, each paying more than the one before
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 100; i++) {
+        CMutableTransaction tx = CMutableTransaction();
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << i;
+        tx.vout.resize(1);
+        tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        tx.vout[0].nValue = 10 * COIN;
+        txs.push_back(MakeTransactionRef(tx));
+        pool.addUnchecked(entry.Fee(1000LL * (i + 1)).FromTx(txs.back()));
+    }
+
+    const size_t nLimit = pool.DynamicMemoryUsage() / 2;
+    pool.TrimToSize(nLimit);
+    BOOST_CHECK(pool.DynamicMemoryUsage() <= nLimit);
+    BOOST_CHECK(pool.size() > 0U && pool.size() < txs.size());
+
+    // The cheapest transactions were evicted in a single pass
+    const size_t nRemoved = txs.size() - pool.size();
+    for (size_t i = 0; i < txs.size(); i++) {
+        BOOST_CHECK_EQUAL(pool.exists(txs[i]->GetHash()), i >= nRemoved);
+    }
+    const CFeeRate removed(1000LL * nRemoved, GetVirtualTransactionSize(*txs[nRemoved - 1]));
+    BOOST_CHECK_EQUAL(pool.GetMinFee(1).GetFeePerK(), removed.GetFeePerK() + 1000);
+}
+
 BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
 {
     size_t ancestors, descendants;
@@ -749,4 +783,112 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
     BOOST_CHECK_EQUAL(descendants, 6ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolDiamondRemoveForBlockTest)
+{
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+
+    //
+    // [tx1].0 <- [tx2] <--+
+    //      .1 <- [tx3] <-- [tx4]
+    //
+    CTransactionRef tx1 = make_tx(/* output_values */ {5 * COIN, 5 * COIN});
+    CTransactionRef tx2 = make_tx(/* output_values */ {4 * COIN}, /* inputs */ {tx1});
+    CTransactionRef tx3 = make_tx(/* output_values */ {4 * COIN}, /* inputs */ {tx1}, /* input_indices */ {1});
+    CTransactionRef tx4 = make_tx(/* output_values */ {7 * COIN}, /* inputs */ {tx2, tx3});
+    for (const CTransactionRef& tx : {tx1, tx2, tx3, tx4}) {
+        pool.addUnchecked(entry.Fee(10000LL).FromTx(tx));
+    }
+
+    // tx1 is reachable from tx4 along two paths but must be counted once.
+    auto it4 = pool.mapTx.find(tx4->GetHash());
+    BOOST_CHECK_EQUAL(it4->GetCountWithAncestors(), 4ULL);
+    BOOST_CHECK_EQUAL(pool.mapTx.find(tx1->GetHash())->GetCountWithDescendants(), 4ULL);
+
+    // Confirming tx1 must update the ancestor state of every descendant once.
+    pool.removeForBlock({tx1}, 1);
+    BOOST_CHECK_EQUAL(pool.size(), 3U);
+    BOOST_CHECK_EQUAL(pool.mapTx.find(tx2->GetHash())->GetCountWithAncestors(), 1ULL);
+    BOOST_CHECK_EQUAL(pool.mapTx.find(tx3->GetHash())->GetCountWithAncestors(), 1ULL);
+    it4 = pool.mapTx.find(tx4->GetHash());
+    BOOST_CHECK_EQUAL(it4->GetCountWithAncestors(), 3ULL);
+    BOOST_CHECK_EQUAL(it4->GetSizeWithAncestors(), it4->GetTxSize() + tx2->GetTotalSize() + tx3->GetTotalSize());
+
+    CTxMemPool::setEntries setDescendants;
+    pool.CalculateDescendants(pool.mapTx.find(tx2->GetHash()), setDescendants);
+    pool.CalculateDescendants(pool.mapTx.find(tx3->GetHash()), setDescendants);
+    BOOST_CHECK_EQUAL(setDescendants.size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(MempoolScriptIndexTest)
+{
+    CTxMemPool pool;
+    LOCK2(cs_main, pool.cs);
+    TestMemPoolEntryHelper entry;
+    fMempoolScriptIndex = true;
+
+    const CScript scriptFunding = CScript() << OP_2 << OP_EQUAL;
+    const CScript scriptPayee = CScript() << OP_11 << OP_EQUAL;
+
+    // A confirmed coin paying to scriptFunding
+    const COutPoint prevout(InsecureRand256(), 0);
+    pcoinsTip->AddCoin(prevout, Coin(CTxOut(10 * COIN, scriptFunding), 1, false), false);
+
+    CMutableTransaction tx1;
+    tx1.vin.emplace_back(prevout);
+    tx1.vout.emplace_back(9 * COIN, scriptPayee);
+    CTransactionRef ptx1 = MakeTransactionRef(tx1);
+    pool.addUnchecked(entry.Time(100).FromTx(ptx1));
+
+    // The in-mempool output is resolved from the pool itself
+    CTransactionRef ptx2 = make_tx(/* output_values */ {8 * COIN}, /* inputs */ {ptx1});
+    pool.addUnchecked(entry.Time(200).FromTx(ptx2));
+
+    // The same transactions without the index take less memory
+    CTxMemPool poolNoIndex;
+    LOCK(poolNoIndex.cs);
+    fMempoolScriptIndex = false;
+    poolNoIndex.addUnchecked(entry.Time(100).FromTx(ptx1));
+    poolNoIndex.addUnchecked(entry.Time(200).FromTx(ptx2));
+    fMempoolScriptIndex = true;
+    BOOST_CHECK(pool.DynamicMemoryUsage() > poolNoIndex.DynamicMemoryUsage());
+
+    std::vector<std::pair<CMempoolScriptDeltaKey, CMempoolScriptDelta>> deltas;
+    pool.getScriptIndex({scriptFunding}, deltas);
+    BOOST_CHECK_EQUAL(deltas.size(), 1U);
+    BOOST_CHECK(deltas[0].first.txhash == ptx1->GetHash());
+    BOOST_CHECK(deltas[0].first.spending);
+    BOOST_CHECK_EQUAL(deltas[0].second.amount, -10 * COIN);
+    BOOST_CHECK(deltas[0].second.prevout == prevout);
+
+    // scriptPayee receives from tx1 and tx2, and is spent by tx2
+    deltas.clear();
+    pool.getScriptIndex({scriptPayee}, deltas);
+    BOOST_CHECK_EQUAL(deltas.size(), 3U);
+    CAmount nBalance = 0;
+    for (const auto& delta : deltas) {
+        nBalance += delta.second.amount;
+    }
+    BOOST_CHECK_EQUAL(nBalance, 8 * COIN);
+
+    std::set<uint160> setScripts;
+    pool.getScriptIndexScripts(ptx1->GetHash(), setScripts);
+    BOOST_CHECK_EQUAL(setScripts.size(), 2U);
+
+    // Removal drops every entry of the removed transactions, and their memory
+    pool.removeRecursive(*ptx1);
+    BOOST_CHECK_EQUAL(pool.size(), 0U);
+    deltas.clear();
+    pool.getScriptIndex({scriptFunding, scriptPayee}, deltas);
+    BOOST_CHECK(deltas.empty());
+    setScripts.clear();
+    pool.getScriptIndexScripts(ptx2->GetHash(), setScripts);
+    BOOST_CHECK(setScripts.empty());
+    poolNoIndex.removeRecursive(*ptx1);
+    BOOST_CHECK_EQUAL(pool.DynamicMemoryUsage(), poolNoIndex.DynamicMemoryUsage());
+
+    fMempoolScriptIndex = DEFAULT_MEMPOOL_SCRIPT_INDEX;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
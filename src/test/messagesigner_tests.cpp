@@ -0,0 +1,61 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <key.h>
+#include <messagesigner.h>
+#include <modules/masternode/masternode.h>
+#include <test/test_chaincoin.h>
+
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(messagesigner_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(legacy_ping_hash)
+{
+    // The legacy hash is formatted without strings; it must match the message old daemons signed.
+    for (const COutPoint& outpoint : {COutPoint(InsecureRand256(), InsecureRand32()), COutPoint(InsecureRand256(), 0), COutPoint()}) {
+        for (int64_t sigTime : {(int64_t)0, (int64_t)1556000000, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min()}) {
+            CMasternodePing mnp;
+            mnp.masternodeOutpoint = outpoint;
+            mnp.blockHash = InsecureRand256();
+            mnp.sigTime = sigTime;
+            const std::string strMessage = CTxIn(outpoint).ToString() + mnp.blockHash.ToString() + std::to_string(sigTime);
+            BOOST_CHECK_EQUAL(mnp.GetLegacySignatureHash(), CMessageSigner::GetMessageHash(strMessage));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(recover_pubkey)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const uint256 hash = InsecureRand256();
+    std::vector<unsigned char> vchSig;
+    BOOST_REQUIRE(CHashSigner::SignHash(hash, key, vchSig));
+
+    // Recovered once from the signature, then from the cache.
+    for (int i = 0; i < 2; i++) {
+        CPubKey pubkey;
+        BOOST_CHECK(CHashSigner::RecoverPubKey(hash, vchSig, pubkey));
+        BOOST_CHECK(pubkey == key.GetPubKey());
+    }
+
+    // Neither another hash nor another signature hits the entry of the pair.
+    CPubKey pubkey;
+    BOOST_CHECK(!CHashSigner::RecoverPubKey(InsecureRand256(), vchSig, pubkey) || pubkey != key.GetPubKey());
+    std::vector<unsigned char> vchBadSig(vchSig);
+    vchBadSig[1] ^= 1;
+    pubkey = CPubKey();
+    BOOST_CHECK(!CHashSigner::RecoverPubKey(hash, vchBadSig, pubkey) || pubkey != key.GetPubKey());
+
+    // A failed recovery is not cached as a success.
+    const std::vector<unsigned char> vchInvalidSig(CPubKey::COMPACT_SIGNATURE_SIZE, 0);
+    for (int i = 0; i < 2; i++) {
+        BOOST_CHECK(!CHashSigner::RecoverPubKey(hash, vchInvalidSig, pubkey));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,68 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <metrics.h>
+#include <test/test_chaincoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(metrics_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(histogram_bounds)
+{
+    const uint64_t* bounds = MetricHistogram::Bounds();
+    BOOST_CHECK_EQUAL(bounds[0], 1U);
+    BOOST_CHECK_EQUAL(bounds[1], 2U);
+    BOOST_CHECK_EQUAL(bounds[2], 3U);
+    BOOST_CHECK_EQUAL(bounds[3], 4U);
+    BOOST_CHECK_EQUAL(bounds[4], 6U);
+    BOOST_CHECK_EQUAL(bounds[MetricHistogram::NUM_BOUNDS - 1], uint64_t{1} << 32);
+    for (int i = 1; i < MetricHistogram::NUM_BOUNDS; i++) {
+        // Each bucket is at most half as wide as its upper bound.
+        BOOST_CHECK(bounds[i] > bounds[i - 1]);
+        BOOST_CHECK(bounds[i] - bounds[i - 1] <= bounds[i] / 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(registry_render)
+{
+    MetricsRegistry registry;
+    registry.Counter("test_total", "A counter", "kind", "a").Inc(3);
+    registry.Counter("test_total", "A counter", "kind", "b\"c").Inc();
+    registry.Counter("test_total", "A counter", "kind", "sampled").Set(7);
+    registry.Gauge("test_gauge", "A gauge").Set(-5);
+    MetricHistogram& histogram = registry.Histogram("test_seconds", "A histogram");
+    histogram.Observe(1);
+    histogram.Observe(5);
+    histogram.Observe(6);
+    histogram.Observe(int64_t{1} << 40);
+
+    // The same name and label return the same metric.
+    BOOST_CHECK_EQUAL(registry.Counter("test_total", "A counter", "kind", "a").Get(), 3U);
+    BOOST_CHECK_EQUAL(histogram.GetCount(), 4U);
+
+    int collected = 0;
+    registry.AddCollector([&collected] { collected++; });
+    const std::string out = registry.Render();
+    BOOST_CHECK_EQUAL(collected, 1);
+
+    auto contains = [&out](const std::string& line) { return out.find(line + "\n") != std::string::npos; };
+    BOOST_CHECK(contains("# HELP test_total A counter"));
+    BOOST_CHECK(contains("# TYPE test_total counter"));
+    BOOST_CHECK(contains("test_total{kind=\"a\"} 3"));
+    BOOST_CHECK(contains("test_total{kind=\"b\\\"c\"} 1"));
+    BOOST_CHECK(contains("test_total{kind=\"sampled\"} 7"));
+    BOOST_CHECK(contains("# TYPE test_gauge gauge"));
+    BOOST_CHECK(contains("test_gauge -5"));
+    BOOST_CHECK(contains("# TYPE test_seconds histogram"));
+    BOOST_CHECK(contains("test_seconds_bucket{le=\"0.000001\"} 1"));
+    BOOST_CHECK(contains("test_seconds_bucket{le=\"0.000004\"} 1"));
+    BOOST_CHECK(contains("test_seconds_bucket{le=\"0.000006\"} 3"));
+    BOOST_CHECK(contains("test_seconds_bucket{le=\"4294.967296\"} 3"));
+    BOOST_CHECK(contains("test_seconds_bucket{le=\"+Inf\"} 4"));
+    BOOST_CHECK(contains("test_seconds_count 4"));
+    BOOST_CHECK(contains("test_seconds_sum 1099511.627788"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
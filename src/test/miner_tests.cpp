@@ -10,7 +10,9 @@
 #include <consensus/validation.h>
 #include <validation.h>
 #include <miner.h>
+#include <metrics.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <pubkey.h>
 #include <script/standard.h>
 #include <txmempool.h>
@@ -521,4 +523,95 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+BOOST_FIXTURE_TEST_CASE(BlockTemplateCacheTest, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    BlockTemplateCache cache(mempool);
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = cache.Get(chainparams, scriptPubKey);
+    BOOST_REQUIRE(pblocktemplate);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - 10 * CENT;
+    tx.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    tx.vin[0].scriptSig << vchSig;
+    const CTransactionRef ptx = MakeTransactionRef(tx);
+
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(AcceptToMemoryPool(mempool, state, ptx, nullptr, nullptr, true, 0));
+    }
+
+    // The new transaction is appended to the cached template
+    pblocktemplate = cache.Get(chainparams, scriptPubKey);
+    BOOST_REQUIRE(pblocktemplate);
+    BOOST_REQUIRE_EQUAL(pblocktemplate->block.vtx.size(), 2U);
+    BOOST_CHECK(pblocktemplate->block.vtx[1]->GetHash() == ptx->GetHash());
+    BOOST_CHECK(pblocktemplate->vTxFees[0] == -10 * CENT);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx[0]->GetValueOut(), GetBlockSubsidy(chainActive.Height() + 1, chainparams.GetConsensus()) + 10 * CENT);
+
+    // Appended transactions are checked on their own, so one whose script
+    // fails is left out even though it made it into the mempool unchecked
+    CMutableTransaction bad_tx = tx;
+    bad_tx.vin[0].prevout = COutPoint(m_coinbase_txns[1]->GetHash(), 0);
+    const CTransactionRef pbad_tx = MakeTransactionRef(bad_tx);
+    {
+        LOCK2(cs_main, mempool.cs);
+        TestMemPoolEntryHelper entry;
+        mempool.addUnchecked(entry.Fee(10 * CENT).FromTx(pbad_tx));
+    }
+    pblocktemplate = cache.Get(chainparams, scriptPubKey);
+    BOOST_REQUIRE(pblocktemplate);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 2U);
+    {
+        LOCK(mempool.cs);
+        mempool.removeRecursive(*pbad_tx, MemPoolRemovalReason::CONFLICT);
+    }
+
+    // Removing it from the mempool invalidates the template
+    {
+        LOCK(mempool.cs);
+        mempool.removeRecursive(*ptx, MemPoolRemovalReason::CONFLICT);
+    }
+    pblocktemplate = cache.Get(chainparams, scriptPubKey);
+    BOOST_REQUIRE(pblocktemplate);
+    BOOST_CHECK_EQUAL(pblocktemplate->block.vtx.size(), 1U);
+
+    // An updated template is a valid block
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(AcceptToMemoryPool(mempool, state, ptx, nullptr, nullptr, true, 0));
+    }
+    const MetricHistogram& update_time = GetMetrics().Histogram("chaincoin_block_template_seconds", "Time spent assembling block templates", "method", "update");
+    const uint64_t updates = update_time.GetCount();
+    pblocktemplate = cache.Get(chainparams, scriptPubKey);
+    BOOST_REQUIRE(pblocktemplate);
+    BOOST_REQUIRE_EQUAL(pblocktemplate->block.vtx.size(), 2U);
+    BOOST_CHECK_EQUAL(update_time.GetCount(), updates + 1);
+    CBlock& block = pblocktemplate->block;
+    {
+        LOCK(cs_main);
+        unsigned int extraNonce = 0;
+        IncrementExtraNonce(&block, chainActive.Tip(), extraNonce);
+    }
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+    BOOST_CHECK(ProcessNewBlock(chainparams, std::make_shared<const CBlock>(block), true, nullptr));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    }
+    BOOST_CHECK(!mempool.exists(ptx->GetHash()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -303,4 +303,18 @@ BOOST_AUTO_TEST_CASE(LocalAddress_BasicLifecycle)
 }
 
 
+BOOST_AUTO_TEST_CASE(net_msg_ids)
+{
+    const std::vector<std::string>& all_messages = getAllNetMessageTypes();
+    BOOST_CHECK_EQUAL(all_messages.size(), static_cast<size_t>(NetMsgId::UNKNOWN));
+    for (size_t i = 0; i < all_messages.size(); i++) {
+        BOOST_CHECK(GetNetMsgId(all_messages[i]) == static_cast<NetMsgId>(i));
+    }
+    BOOST_CHECK(GetNetMsgId(NetMsgType::VERSION) == NetMsgId::VERSION);
+    BOOST_CHECK(GetNetMsgId(NetMsgType::MNGOVERNANCEOBJECTVOTE) == NetMsgId::MNGOVERNANCEOBJECTVOTE);
+    BOOST_CHECK(GetNetMsgId("") == NetMsgId::UNKNOWN);
+    BOOST_CHECK(GetNetMsgId("versio") == NetMsgId::UNKNOWN);
+    BOOST_CHECK(GetNetMsgId(NET_MESSAGE_COMMAND_OTHER) == NetMsgId::UNKNOWN);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <key.h>
+#include <messagesigner.h>
+#include <script/sigcache.h>
+#include <test/test_chaincoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(sigcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sigcache_shards)
+{
+    CSignatureCache cache;
+
+    // Shard counts are rounded down to a power of two and clamped.
+    cache.Setup(1 << 20, 0);
+    BOOST_CHECK_EQUAL(cache.GetShardCount(), 1U);
+    cache.Setup(1 << 20, 12);
+    BOOST_CHECK_EQUAL(cache.GetShardCount(), 8U);
+    cache.Setup(1 << 20, 100000);
+    BOOST_CHECK_EQUAL(cache.GetShardCount(), MAX_SIGCACHE_SHARDS);
+    cache.Setup(1 << 20, DEFAULT_SIGCACHE_SHARDS);
+    BOOST_CHECK_EQUAL(cache.GetShardCount(), DEFAULT_SIGCACHE_SHARDS);
+
+    // Entries land in every shard, and each is found again.
+    std::vector<uint256> entries;
+    for (int i = 0; i < 256; ++i) {
+        entries.push_back(InsecureRand256());
+        cache.Set(entries.back());
+    }
+    for (const uint256& entry : entries) {
+        BOOST_CHECK(cache.Get(entry, false));
+    }
+    BOOST_CHECK(!cache.Get(InsecureRand256(), false));
+    BOOST_CHECK_EQUAL(cache.GetHits(), entries.size());
+    BOOST_CHECK_EQUAL(cache.GetMisses(), 1U);
+
+    // Erasing only lets a later insert reuse the slot; the lookup still hits.
+    BOOST_CHECK(cache.Get(entries[0], true));
+    BOOST_CHECK_EQUAL(cache.GetHits(), entries.size() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(message_signature_cache)
+{
+    CKey key, other_key;
+    key.MakeNewKey(true);
+    other_key.MakeNewKey(true);
+    const uint256 hash = InsecureRand256();
+    std::vector<unsigned char> vchSig;
+    std::string strError;
+    BOOST_REQUIRE(CHashSigner::SignHash(hash, key, vchSig));
+
+    BOOST_CHECK(!IsMessageSignatureCached(hash, vchSig, key.GetPubKey()));
+    BOOST_CHECK(CHashSigner::VerifyHash(hash, key.GetPubKey(), vchSig, strError));
+    BOOST_CHECK(IsMessageSignatureCached(hash, vchSig, key.GetPubKey()));
+
+    // A cached signature is only good for the hash and key it was checked with.
+    const uint64_t hits = GetMessageSignatureCacheHits();
+    BOOST_CHECK(CHashSigner::VerifyHash(hash, key.GetPubKey(), vchSig, strError));
+    BOOST_CHECK_EQUAL(GetMessageSignatureCacheHits(), hits + 1);
+    BOOST_CHECK(!CHashSigner::VerifyHash(hash, other_key.GetPubKey(), vchSig, strError));
+    BOOST_CHECK(!CHashSigner::VerifyHash(InsecureRand256(), key.GetPubKey(), vchSig, strError));
+    BOOST_CHECK(!IsMessageSignatureCached(hash, vchSig, other_key.GetPubKey()));
+
+    // Malformed signatures are rejected without a lookup.
+    BOOST_CHECK(!CHashSigner::VerifyHash(hash, key.GetPubKey(), std::vector<unsigned char>(), strError));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
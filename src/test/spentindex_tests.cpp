@@ -0,0 +1,104 @@
+// Copyright (c) 2019 PM-Tech
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/spentindex.h>
+#include <miner.h>
+#include <pow.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/test_chaincoin.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(spentindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(spentindex_initial_sync, TestChain100Setup)
+{
+    SpentIndex spentindex(1 << 20, true);
+
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Spend the first two coinbases in two blocks before the index is started.
+    std::vector<CMutableTransaction> spends;
+    for (size_t i = 0; i < 2; i++) {
+        const CTransactionRef& spent = m_coinbase_txns[i];
+        CMutableTransaction spend;
+        spend.vin.resize(1);
+        spend.vin[0].prevout = COutPoint(spent->GetHash(), 0);
+        spend.vout.resize(1);
+        spend.vout[0].nValue = spent->vout[0].nValue - CENT;
+        spend.vout[0].scriptPubKey = coinbase_script;
+        std::vector<unsigned char> sig;
+        uint256 hash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+        sig.push_back((unsigned char)SIGHASH_ALL);
+        spend.vin[0].scriptSig << sig;
+        spends.push_back(spend);
+    }
+    MineBlock({spends[0]}, coinbase_script);
+
+    SpentIndexEntry entry;
+    BOOST_CHECK(!spentindex.FindSpender(spends[0].vin[0].prevout, entry));
+
+    // BlockUntilSyncedToCurrentChain should return false before spentindex is started.
+    BOOST_CHECK(!spentindex.BlockUntilSyncedToCurrentChain());
+
+    spentindex.Start();
+
+    // Allow spentindex to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!spentindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    const int height1 = m_coinbase_txns.size() + 1;
+    BOOST_CHECK(spentindex.FindSpender(spends[0].vin[0].prevout, entry));
+    BOOST_CHECK(entry.txid == spends[0].GetHash());
+    BOOST_CHECK_EQUAL(entry.input_index, 0U);
+    BOOST_CHECK_EQUAL(entry.height, height1);
+    BOOST_CHECK(!spentindex.FindSpender(COutPoint(spends[0].GetHash(), 0), entry));
+    BOOST_CHECK(!spentindex.FindSpender(spends[1].vin[0].prevout, entry));
+
+    // Check that new spends are indexed through the validation interface.
+    const CBlock block2 = MineBlock({spends[1]}, coinbase_script);
+    BOOST_CHECK(spentindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(spentindex.FindSpender(spends[1].vin[0].prevout, entry));
+    BOOST_CHECK(entry.txid == spends[1].GetHash());
+    BOOST_CHECK_EQUAL(entry.height, height1 + 1);
+
+    // Replace the second block: the index rewinds it before connecting the new tip.
+    {
+        CValidationState state;
+        CBlockIndex* pindex;
+        {
+            LOCK(cs_main);
+            pindex = LookupBlockIndex(block2.GetHash());
+        }
+        BOOST_REQUIRE(InvalidateBlock(state, Params(), pindex));
+        BOOST_REQUIRE(ActivateBestChain(state, Params()));
+    }
+    // The spend was returned to the mempool; drop it so the template's coinbase
+    // does not claim its fee.
+    mempool.clear();
+    MineBlock({}, coinbase_script);
+    BOOST_CHECK(spentindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(!spentindex.FindSpender(spends[1].vin[0].prevout, entry));
+    BOOST_CHECK(spentindex.FindSpender(spends[0].vin[0].prevout, entry));
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    spentindex.Stop();
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+
+    // Rest of shutdown sequence and destructors happen in ~TestingSetup()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,9 @@
 #include <sync.h>
 #include <test/test_bitcoin.h>
 
+#include <algorithm>
+#include <thread>
+
 #include <boost/test/unit_test.hpp>
 
 namespace {
@@ -49,4 +52,70 @@ BOOST_AUTO_TEST_CASE(potential_deadlock_detected)
     #endif
 }
 
+BOOST_AUTO_TEST_CASE(lock_stats)
+{
+    const bool prev = g_lock_stats_enabled;
+    CCriticalSection cs_stats_test;
+
+    auto find_site = [](const char* name) {
+        std::vector<LockSiteStats> stats = GetLockStats();
+        auto it = std::find_if(stats.begin(), stats.end(), [name](const LockSiteStats& site) { return site.name == name; });
+        BOOST_REQUIRE(it != stats.end());
+        return *it;
+    };
+
+    // Nothing is recorded while collection is off.
+    g_lock_stats_enabled = false;
+    {
+        LOCK(cs_stats_test);
+    }
+    for (const LockSiteStats& site : GetLockStats()) {
+        BOOST_CHECK(site.name != "cs_stats_test");
+    }
+
+    g_lock_stats_enabled = true;
+    std::thread holder;
+    {
+        LOCK(cs_stats_test);
+        holder = std::thread([&cs_stats_test] {
+            LOCK(cs_stats_test);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    holder.join();
+
+    uint64_t acquisitions = 0, contentions = 0, wait_total_us = 0, held = 0;
+    for (const LockSiteStats& site : GetLockStats()) {
+        if (site.name != "cs_stats_test") continue;
+        acquisitions += site.acquisitions;
+        contentions += site.contentions;
+        wait_total_us += site.wait_total_us;
+        for (uint64_t count : site.hold_buckets) held += count;
+    }
+    BOOST_CHECK_EQUAL(acquisitions, 2U);
+    BOOST_CHECK_EQUAL(contentions, 1U);
+    BOOST_CHECK(wait_total_us >= 10000);
+    BOOST_CHECK_EQUAL(held, 2U);
+
+    // Sites naming the same mutex differently record it, so their counters can be summed up.
+    CCriticalSection& cs_stats_alias = cs_stats_test;
+    {
+        LOCK(cs_stats_alias);
+    }
+    BOOST_CHECK(find_site("cs_stats_test").mutex == &cs_stats_test);
+    BOOST_CHECK(find_site("cs_stats_alias").mutex == &cs_stats_test);
+
+    // A site taking several instances records none.
+    CCriticalSection cs_stats_other;
+    for (CCriticalSection* pcs_stats : {&cs_stats_test, &cs_stats_other}) {
+        LOCK(*pcs_stats);
+    }
+    BOOST_CHECK(find_site("*pcs_stats").mutex == nullptr);
+
+    ResetLockStats();
+    BOOST_CHECK_EQUAL(find_site("cs_stats_test").acquisitions, 0U);
+
+    g_lock_stats_enabled = prev;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
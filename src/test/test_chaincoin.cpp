@@ -155,6 +155,35 @@ TestChain100Setup::CreateAndProcessBlock(const std::vector<CMutableTransaction>&
     return result;
 }
 
+CBlock
+TestChain100Setup::MineBlock(const std::vector<CMutableTransaction>& txns, const CScript& scriptPubKey)
+{
+    const CChainParams& chainparams = Params();
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(scriptPubKey);
+    CBlock& block = pblocktemplate->block;
+    block.vtx.resize(1);
+    for (const CMutableTransaction& tx : txns) {
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+    {
+        LOCK(cs_main);
+        CMutableTransaction coinbase(*block.vtx[0]);
+        coinbase.vout.resize(1);
+        block.vtx[0] = MakeTransactionRef(coinbase);
+        GenerateCoinbaseCommitment(block, chainActive.Tip(), chainparams.GetConsensus());
+        unsigned int extraNonce = 0;
+        IncrementExtraNonce(&block, chainActive.Tip(), extraNonce);
+    }
+
+    while (!CheckProofOfWork(block.GetHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+
+    bool fNewBlock = ProcessNewBlock(chainparams, std::make_shared<const CBlock>(block), true, nullptr);
+    assert(fNewBlock);
+    LOCK(cs_main);
+    assert(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    return block;
+}
+
 TestChain100Setup::~TestChain100Setup()
 {
 }
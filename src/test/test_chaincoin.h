@@ -99,6 +99,12 @@ struct TestChain100Setup : public TestingSetup {
     CBlock CreateAndProcessBlock(const std::vector<CMutableTransaction>& txns,
                                  const CScript& scriptPubKey);
 
+    // Like CreateAndProcessBlock, but recommits the coinbase to the witness
+    // root of the given transactions instead of the mempool's, and requires
+    // the block to become the new tip.
+    CBlock MineBlock(const std::vector<CMutableTransaction>& txns,
+                     const CScript& scriptPubKey);
+
     ~TestChain100Setup();
 
     std::vector<CTransactionRef> m_coinbase_txns; // For convenience, coinbase transactions
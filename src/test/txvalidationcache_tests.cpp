@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <chainparams.h>
 #include <consensus/validation.h>
 #include <key.h>
 #include <validation.h>
@@ -91,6 +92,70 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChain100Setup)
     BOOST_CHECK_EQUAL(mempool.size(), 0U);
 }
 
+BOOST_FIXTURE_TEST_CASE(tx_mempool_parallel_script_checks, TestChain100Setup)
+{
+    // Transactions with at least MIN_PARALLEL_MEMPOOL_SCRIPT_CHECKS inputs
+    // have their scripts verified on the script check threads before the
+    // serial CheckInputs pass. Make sure both outcomes are reported the same
+    // way as for the serial path.
+    CScript scriptPubKey = CScript() <<  ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const unsigned int nInputs = MIN_PARALLEL_MEMPOOL_SCRIPT_CHECKS + 1;
+
+    CMutableTransaction fund_tx;
+    fund_tx.nVersion = 1;
+    fund_tx.vin.resize(1);
+    fund_tx.vin[0].prevout.hash = m_coinbase_txns[0]->GetHash();
+    fund_tx.vin[0].prevout.n = 0;
+    fund_tx.vout.resize(nInputs);
+    for (unsigned int i = 0; i < nInputs; i++) {
+        fund_tx.vout[i].nValue = 11*CENT;
+        fund_tx.vout[i].scriptPubKey = scriptPubKey;
+    }
+    {
+        std::vector<unsigned char> vchSig;
+        uint256 hash = SignatureHash(scriptPubKey, fund_tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        fund_tx.vin[0].scriptSig << vchSig;
+    }
+    BOOST_CHECK(ToMemPool(fund_tx));
+
+    CMutableTransaction spend_tx;
+    spend_tx.nVersion = 1;
+    spend_tx.vin.resize(nInputs);
+    for (unsigned int i = 0; i < nInputs; i++) {
+        spend_tx.vin[i].prevout = COutPoint(fund_tx.GetHash(), i);
+    }
+    spend_tx.vout.resize(1);
+    spend_tx.vout[0].nValue = 11*CENT;
+    spend_tx.vout[0].scriptPubKey = scriptPubKey;
+
+    std::vector<std::vector<unsigned char>> vchSigs(nInputs);
+    for (unsigned int i = 0; i < nInputs; i++) {
+        uint256 hash = SignatureHash(scriptPubKey, spend_tx, i, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_CHECK(coinbaseKey.Sign(hash, vchSigs[i]));
+        vchSigs[i].push_back((unsigned char)SIGHASH_ALL);
+    }
+
+    // Swap two signatures: every input carries a well-formed signature but
+    // two of them do not commit to their own input.
+    CMutableTransaction bad_tx = spend_tx;
+    for (unsigned int i = 0; i < nInputs; i++) {
+        bad_tx.vin[i].scriptSig = CScript() << vchSigs[i == 1 ? 2 : i == 2 ? 1 : i];
+        spend_tx.vin[i].scriptSig = CScript() << vchSigs[i];
+    }
+
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(!AcceptToMemoryPool(mempool, state, MakeTransactionRef(bad_tx), nullptr, nullptr, true, 0));
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), "mandatory-script-verify-flag-failed (Signature must be zero for failed CHECK(MULTI)SIG operation)");
+    }
+    BOOST_CHECK(ToMemPool(spend_tx));
+    BOOST_CHECK_EQUAL(mempool.size(), 2U);
+    mempool.clear();
+}
+
 // Run CheckInputs (using pcoinsTip) on the given transaction, for all script
 // flags.  Test that CheckInputs passes for all flags that don't overlap with
 // the failing_flags argument, but otherwise fails.
@@ -141,6 +206,58 @@ static void ValidateCheckInputsForAllFlags(const CTransaction &tx, uint32_t fail
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(tx_block_check_caches_scripts, TestChain100Setup)
+{
+    // Scripts verified on the script check threads while testing a block's
+    // validity are added to the script execution cache, so connecting the
+    // block afterwards doesn't execute them again.
+    CScript scriptPubKey = CScript() <<  ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout.hash = m_coinbase_txns[0]->GetHash();
+    spend.vin[0].prevout.n = 0;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = 11*CENT;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+    const CTransaction tx(spend);
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptPubKey);
+    CBlock& block = pblocktemplate->block;
+    block.vtx.resize(1);
+    block.vtx.push_back(MakeTransactionRef(spend));
+
+    LOCK(cs_main);
+    // Drop the witness commitment of the template (there are no masternode
+    // payees on the test chain) and recommit to the new transaction list
+    CMutableTransaction coinbase(*block.vtx[0]);
+    coinbase.vout.resize(1);
+    block.vtx[0] = MakeTransactionRef(coinbase);
+    GenerateCoinbaseCommitment(block, chainActive.Tip(), Params().GetConsensus());
+    unsigned int extraNonce = 0;
+    IncrementExtraNonce(&block, chainActive.Tip(), extraNonce);
+
+    // Script flags of block 101 on regtest
+    const unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_NULLDUMMY;
+    CValidationState state;
+    PrecomputedTransactionData txdata(tx);
+    std::vector<CScriptCheck> scriptchecks;
+    BOOST_CHECK(CheckInputs(tx, state, pcoinsTip.get(), true, flags, true, true, txdata, &scriptchecks));
+    BOOST_CHECK_EQUAL(scriptchecks.size(), 1U);
+
+    BOOST_CHECK(TestBlockValidity(state, Params(), block, chainActive.Tip(), false, true));
+
+    scriptchecks.clear();
+    BOOST_CHECK(CheckInputs(tx, state, pcoinsTip.get(), true, flags, true, true, txdata, &scriptchecks));
+    BOOST_CHECK(scriptchecks.empty());
+}
+
 BOOST_FIXTURE_TEST_CASE(checkinputs_test, TestChain100Setup)
 {
     // Test that passing CheckInputs with one set of script flags doesn't imply
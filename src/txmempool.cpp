@@ -8,6 +8,7 @@
 #include <consensus/consensus.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
+#include <hash.h>
 #include <validation.h>
 #include <policy/policy.h>
 #include <policy/fees.h>
@@ -22,7 +23,7 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFe
                                  int64_t _nTime, unsigned int _entryHeight,
                                  bool _spendsCoinbase, int64_t _sigOpsCost, LockPoints lp)
     : tx(_tx), nFee(_nFee), nTxWeight(GetTransactionWeight(*tx)), nUsageSize(RecursiveDynamicUsage(tx)), nTime(_nTime), entryHeight(_entryHeight),
-    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp)
+    spendsCoinbase(_spendsCoinbase), sigOpCost(_sigOpsCost), lockPoints(lp), m_epoch(0)
 {
     nCountWithDescendants = 1;
     nSizeWithDescendants = GetTxSize();
@@ -58,13 +59,18 @@ size_t CTxMemPoolEntry::GetTxSize() const
 // descendants.
 void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendants, const std::set<uint256> &setExclude)
 {
-    setEntries stageEntries, setAllDescendants;
-    stageEntries = GetMemPoolChildren(updateIt);
+    std::vector<txiter> stageEntries, vAllDescendants;
+    const EpochGuard epoch(*this);
+
+    for (txiter childEntry : GetMemPoolChildren(updateIt)) {
+        visited(childEntry);
+        stageEntries.push_back(childEntry);
+    }
 
     while (!stageEntries.empty()) {
-        const txiter cit = *stageEntries.begin();
-        setAllDescendants.insert(cit);
-        stageEntries.erase(cit);
+        const txiter cit = stageEntries.back();
+        stageEntries.pop_back();
+        vAllDescendants.push_back(cit);
         const setEntries &setChildren = GetMemPoolChildren(cit);
         for (txiter childEntry : setChildren) {
             cacheMap::iterator cacheIt = cachedDescendants.find(childEntry);
@@ -72,20 +78,22 @@ void CTxMemPool::UpdateForDescendants(txiter updateIt, cacheMap &cachedDescendan
                 // We've already calculated this one, just add the entries for this set
                 // but don't traverse again.
                 for (txiter cacheEntry : cacheIt->second) {
-                    setAllDescendants.insert(cacheEntry);
+                    if (!visited(cacheEntry)) {
+                        vAllDescendants.push_back(cacheEntry);
+                    }
                 }
-            } else if (!setAllDescendants.count(childEntry)) {
+            } else if (!visited(childEntry)) {
                 // Schedule for later processing
-                stageEntries.insert(childEntry);
+                stageEntries.push_back(childEntry);
             }
         }
     }
-    // setAllDescendants now contains all in-mempool descendants of updateIt.
-    // Update and add to cached descendant map
+    // vAllDescendants now contains all in-mempool descendants of updateIt,
+    // each exactly once. Update and add to cached descendant map
     int64_t modifySize = 0;
     CAmount modifyFee = 0;
     int64_t modifyCount = 0;
-    for (txiter cit : setAllDescendants) {
+    for (txiter cit : vAllDescendants) {
         if (!setExclude.count(cit->GetTx().GetHash())) {
             modifySize += cit->GetTxSize();
             modifyFee += cit->GetModifiedFee();
@@ -148,8 +156,15 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256> &vHashes
 
 bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntries &setAncestors, uint64_t limitAncestorCount, uint64_t limitAncestorSize, uint64_t limitDescendantCount, uint64_t limitDescendantSize, std::string &errString, bool fSearchForParents /* = true */) const
 {
-    setEntries parentHashes;
+    // Entries staged for processing. Every entry is staged at most once as
+    // the epoch marks both staged entries and ones already in setAncestors.
+    std::vector<txiter> parentHashes;
     const CTransaction &tx = entry.GetTx();
+    const EpochGuard epoch(*this);
+
+    for (txiter it : setAncestors) {
+        visited(it);
+    }
 
     if (fSearchForParents) {
         // Get parents of this transaction that are in the mempool
@@ -157,8 +172,8 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         // iterate mapTx to find parents.
         for (unsigned int i = 0; i < tx.vin.size(); i++) {
             boost::optional<txiter> piter = GetIter(tx.vin[i].prevout.hash);
-            if (piter) {
-                parentHashes.insert(*piter);
+            if (piter && !visited(*piter)) {
+                parentHashes.push_back(*piter);
                 if (parentHashes.size() + 1 > limitAncestorCount) {
                     errString = strprintf("too many unconfirmed parents [limit: %u]", limitAncestorCount);
                     return false;
@@ -169,16 +184,20 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         // If we're not searching for parents, we require this to be an
         // entry in the mempool already.
         txiter it = mapTx.iterator_to(entry);
-        parentHashes = GetMemPoolParents(it);
+        for (txiter piter : GetMemPoolParents(it)) {
+            if (!visited(piter)) {
+                parentHashes.push_back(piter);
+            }
+        }
     }
 
     size_t totalSizeWithAncestors = entry.GetTxSize();
 
     while (!parentHashes.empty()) {
-        txiter stageit = *parentHashes.begin();
+        txiter stageit = parentHashes.back();
 
         setAncestors.insert(stageit);
-        parentHashes.erase(stageit);
+        parentHashes.pop_back();
         totalSizeWithAncestors += stageit->GetTxSize();
 
         if (stageit->GetSizeWithDescendants() + entry.GetTxSize() > limitDescendantSize) {
@@ -195,8 +214,8 @@ bool CTxMemPool::CalculateMemPoolAncestors(const CTxMemPoolEntry &entry, setEntr
         const setEntries & setMemPoolParents = GetMemPoolParents(stageit);
         for (txiter phash : setMemPoolParents) {
             // If this is a new ancestor, add it.
-            if (setAncestors.count(phash) == 0) {
-                parentHashes.insert(phash);
+            if (!visited(phash)) {
+                parentHashes.push_back(phash);
             }
             if (parentHashes.size() + setAncestors.size() + 1 > limitAncestorCount) {
                 errString = strprintf("too many unconfirmed ancestors [limit: %u]", limitAncestorCount);
@@ -257,15 +276,27 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // Here we only update statistics and not data in mapLinks (which
         // we need to preserve until we're finished with all operations that
         // need to traverse the mempool).
+        std::vector<txiter> stage;
         for (txiter removeIt : entriesToRemove) {
-            setEntries setDescendants;
-            CalculateDescendants(removeIt, setDescendants);
-            setDescendants.erase(removeIt); // don't update state for self
+            const EpochGuard epoch(*this);
             int64_t modifySize = -((int64_t)removeIt->GetTxSize());
             CAmount modifyFee = -removeIt->GetModifiedFee();
             int modifySigOps = -removeIt->GetSigOpCost();
-            for (txiter dit : setDescendants) {
-                mapTx.modify(dit, update_ancestor_state(modifySize, modifyFee, -1, modifySigOps));
+            // Walk the descendants of removeIt (not including itself) and
+            // update their ancestor state as we go.
+            visited(removeIt);
+            stage.push_back(removeIt);
+            while (!stage.empty()) {
+                txiter it = stage.back();
+                stage.pop_back();
+                if (it != removeIt) {
+                    mapTx.modify(it, update_ancestor_state(modifySize, modifyFee, -1, modifySigOps));
+                }
+                for (txiter childiter : GetMemPoolChildren(it)) {
+                    if (!visited(childiter)) {
+                        stage.push_back(childiter);
+                    }
+                }
             }
         }
     }
@@ -291,6 +322,18 @@ void CTxMemPool::UpdateForRemoveFromMempool(const setEntries &entriesToRemove, b
         // and it's important that we use the mapLinks[] notion of ancestor
         // transactions as the set of things to update for removal.
         CalculateMemPoolAncestors(entry, setAncestors, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+        if (!updateDescendants) {
+            // Without updateDescendants all descendants of removeIt are being
+            // removed along with it, so ancestors which are removed as well
+            // don't need their descendant state updated.
+            for (auto ancestorIt = setAncestors.begin(); ancestorIt != setAncestors.end();) {
+                if (entriesToRemove.count(*ancestorIt)) {
+                    ancestorIt = setAncestors.erase(ancestorIt);
+                } else {
+                    ++ancestorIt;
+                }
+            }
+        }
         // Note that UpdateAncestorsOf severs the child links that point to
         // removeIt in the entries for the parents of removeIt.
         UpdateAncestorsOf(false, removeIt, setAncestors);
@@ -324,7 +367,7 @@ void CTxMemPoolEntry::UpdateAncestorState(int64_t modifySize, CAmount modifyFee,
 }
 
 CTxMemPool::CTxMemPool(CBlockPolicyEstimator* estimator) :
-    nTransactionsUpdated(0), minerPolicyEstimator(estimator)
+    nTransactionsUpdated(0), minerPolicyEstimator(estimator), m_epoch(0), m_has_epoch_guard(false)
 {
     _clear(); //lock free clear
 
@@ -354,6 +397,10 @@ void CTxMemPool::AddTransactionsUpdated(unsigned int n)
 
 void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAncestors, bool validFeeEstimate)
 {
+    // Index before notifying, so listeners can look up the spent scripts
+    if (fMempoolScriptIndex) {
+        addScriptIndex(entry);
+    }
     NotifyEntryAdded(entry.GetSharedTx());
     // Add to memory pool without checking anything.
     // Used by AcceptToMemoryPool(), which DOES do
@@ -423,11 +470,83 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     cachedInnerUsage -= it->DynamicMemoryUsage();
     cachedInnerUsage -= memusage::DynamicUsage(mapLinks[it].parents) + memusage::DynamicUsage(mapLinks[it].children);
     mapLinks.erase(it);
+    removeScriptIndex(hash);
     mapTx.erase(it);
     nTransactionsUpdated++;
     if (minerPolicyEstimator) {minerPolicyEstimator->removeTx(hash, false);}
 }
 
+void CTxMemPool::addScriptIndex(const CTxMemPoolEntry& entry)
+{
+    AssertLockHeld(cs);
+    AssertLockHeld(cs_main);
+    const CTransaction& tx = entry.GetTx();
+    const uint256& txhash = tx.GetHash();
+    std::vector<CMempoolScriptDeltaKey> inserted;
+    inserted.reserve(tx.vin.size() + tx.vout.size());
+
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        const COutPoint& prevout = tx.vin[i].prevout;
+        const CTxOut* prevtxout = nullptr;
+        indexed_transaction_set::const_iterator parent = mapTx.find(prevout.hash);
+        if (parent != mapTx.end()) {
+            if (prevout.n < parent->GetTx().vout.size()) prevtxout = &parent->GetTx().vout[prevout.n];
+        } else if (pcoinsTip) {
+            const Coin& coin = pcoinsTip->AccessCoin(prevout);
+            if (!coin.IsSpent()) prevtxout = &coin.out;
+        }
+        if (!prevtxout) continue;
+        const CScript& script = prevtxout->scriptPubKey;
+        CMempoolScriptDeltaKey key(Hash160(script.begin(), script.end()), txhash, i, true);
+        mapScriptDeltas.emplace(key, CMempoolScriptDelta(entry.GetTime(), -prevtxout->nValue, prevout));
+        inserted.push_back(key);
+    }
+
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        const CScript& script = tx.vout[i].scriptPubKey;
+        CMempoolScriptDeltaKey key(Hash160(script.begin(), script.end()), txhash, i, false);
+        mapScriptDeltas.emplace(key, CMempoolScriptDelta(entry.GetTime(), tx.vout[i].nValue));
+        inserted.push_back(key);
+    }
+
+    cachedScriptIndexUsage += memusage::DynamicUsage(inserted);
+    mapScriptDeltasInserted.emplace(txhash, std::move(inserted));
+}
+
+void CTxMemPool::removeScriptIndex(const uint256& txhash)
+{
+    AssertLockHeld(cs);
+    auto it = mapScriptDeltasInserted.find(txhash);
+    if (it == mapScriptDeltasInserted.end()) return;
+    for (const CMempoolScriptDeltaKey& key : it->second) {
+        mapScriptDeltas.erase(key);
+    }
+    cachedScriptIndexUsage -= memusage::DynamicUsage(it->second);
+    mapScriptDeltasInserted.erase(it);
+}
+
+void CTxMemPool::getScriptIndex(const std::vector<CScript>& scripts, std::vector<std::pair<CMempoolScriptDeltaKey, CMempoolScriptDelta>>& results) const
+{
+    LOCK(cs);
+    for (const CScript& script : scripts) {
+        const uint160 scriptHash = Hash160(script.begin(), script.end());
+        for (auto it = mapScriptDeltas.lower_bound(CMempoolScriptDeltaKey(scriptHash));
+             it != mapScriptDeltas.end() && it->first.scriptHash == scriptHash; ++it) {
+            results.push_back(*it);
+        }
+    }
+}
+
+void CTxMemPool::getScriptIndexScripts(const uint256& txhash, std::set<uint160>& scriptHashes) const
+{
+    LOCK(cs);
+    auto it = mapScriptDeltasInserted.find(txhash);
+    if (it == mapScriptDeltasInserted.end()) return;
+    for (const CMempoolScriptDeltaKey& key : it->second) {
+        scriptHashes.insert(key.scriptHash);
+    }
+}
+
 // Calculates descendants of entry that are not already in setDescendants, and adds to
 // setDescendants. Assumes entryit is already a tx in the mempool and setMemPoolChildren
 // is correct for tx and all descendants.
@@ -436,22 +555,21 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 // can save time by not iterating over those entries.
 void CTxMemPool::CalculateDescendants(txiter entryit, setEntries& setDescendants) const
 {
-    setEntries stage;
-    if (setDescendants.count(entryit) == 0) {
-        stage.insert(entryit);
+    std::vector<txiter> stage;
+    if (setDescendants.insert(entryit).second) {
+        stage.push_back(entryit);
     }
     // Traverse down the children of entry, only adding children that are not
     // accounted for in setDescendants already (because those children have either
     // already been walked, or will be walked in this iteration).
     while (!stage.empty()) {
-        txiter it = *stage.begin();
-        setDescendants.insert(it);
-        stage.erase(it);
+        txiter it = stage.back();
+        stage.pop_back();
 
         const setEntries &setChildren = GetMemPoolChildren(it);
         for (txiter childiter : setChildren) {
-            if (!setDescendants.count(childiter)) {
-                stage.insert(childiter);
+            if (setDescendants.insert(childiter).second) {
+                stage.push_back(childiter);
             }
         }
     }
@@ -580,8 +698,11 @@ void CTxMemPool::_clear()
     mapLinks.clear();
     mapTx.clear();
     mapNextTx.clear();
+    mapScriptDeltas.clear();
+    mapScriptDeltasInserted.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
+    cachedScriptIndexUsage = 0;
     lastRollingFeeUpdate = GetTime();
     blockSinceLastRollingFeeBump = false;
     rollingMinimumFeeRate = 0;
@@ -908,10 +1029,31 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return base->GetCoin(outpoint, coin);
 }
 
+// Estimate the overhead of mapTx to be 12 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
+static size_t MapTxEntryUsage()
+{
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*));
+}
+
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
-    // Estimate the overhead of mapTx to be 12 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 12 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return MapTxEntryUsage() * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(mapLinks) + memusage::DynamicUsage(vTxHashes) + memusage::DynamicUsage(mapScriptDeltas) + memusage::DynamicUsage(mapScriptDeltasInserted) + cachedScriptIndexUsage + cachedInnerUsage;
+}
+
+size_t CTxMemPool::EntryDynamicMemoryUsage(txiter entry) const
+{
+    AssertLockHeld(cs);
+    const TxLinks& links = mapLinks.find(entry)->second;
+    size_t usage = MapTxEntryUsage() + entry->DynamicMemoryUsage() +
+                   entry->GetTx().vin.size() * memusage::IncrementalDynamicUsage(mapNextTx) +
+                   memusage::IncrementalDynamicUsage(mapLinks) +
+                   2 * (memusage::DynamicUsage(links.parents) + memusage::DynamicUsage(links.children));
+    auto inserted = mapScriptDeltasInserted.find(entry->GetTx().GetHash());
+    if (inserted != mapScriptDeltasInserted.end()) {
+        usage += memusage::IncrementalDynamicUsage(mapScriptDeltasInserted) + memusage::DynamicUsage(inserted->second) +
+                 inserted->second.size() * memusage::IncrementalDynamicUsage(mapScriptDeltas);
+    }
+    return usage;
 }
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason) {
@@ -1020,20 +1162,39 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
 
     unsigned nTxnRemoved = 0;
     CFeeRate maxFeeRateRemoved(0);
-    while (!mapTx.empty() && DynamicMemoryUsage() > sizelimit) {
-        indexed_transaction_set::index<descendant_score>::type::iterator it = mapTx.get<descendant_score>().begin();
-
-        // We set the new mempool min fee to the feerate of the removed set, plus the
-        // "minimum reasonable fee rate" (ie some value under which we consider txn
-        // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
-        // equal to txn which were removed with no block in between.
-        CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
-        removed += incrementalRelayFee;
-        trackPackageRemoved(removed);
-        maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
-
+    size_t nUsage = DynamicMemoryUsage();
+    while (!mapTx.empty() && nUsage > sizelimit) {
+        // Stage the packages with the lowest descendant score, in the order of
+        // the index at the start of the pass, until removing them brings us
+        // under the limit, and remove them all at once. The memory estimate
+        // errs on the high side, so another pass may be needed.
         setEntries stage;
-        CalculateDescendants(mapTx.project<0>(it), stage);
+        size_t nFreed = 0;
+        std::vector<txiter> todo;
+        for (auto it = mapTx.get<descendant_score>().begin(); it != mapTx.get<descendant_score>().end() && nUsage > sizelimit + nFreed; ++it) {
+            txiter entryit = mapTx.project<0>(it);
+            if (!stage.insert(entryit).second) continue;
+
+            // We set the new mempool min fee to the feerate of the removed set, plus the
+            // "minimum reasonable fee rate" (ie some value under which we consider txn
+            // to have 0 fee). This way, we don't allow txn to enter mempool with feerate
+            // equal to txn which were removed with no block in between.
+            CFeeRate removed(it->GetModFeesWithDescendants(), it->GetSizeWithDescendants());
+            removed += incrementalRelayFee;
+            maxFeeRateRemoved = std::max(maxFeeRateRemoved, removed);
+
+            todo.push_back(entryit);
+            while (!todo.empty()) {
+                txiter descit = todo.back();
+                todo.pop_back();
+                nFreed += EntryDynamicMemoryUsage(descit);
+                for (txiter childit : mapLinks.find(descit)->second.children) {
+                    if (stage.insert(childit).second) {
+                        todo.push_back(childit);
+                    }
+                }
+            }
+        }
         nTxnRemoved += stage.size();
 
         std::vector<CTransaction> txn;
@@ -1042,6 +1203,7 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
             for (txiter iter : stage)
                 txn.push_back(iter->GetTx());
         }
+        // The stage is closed under descendants, so no descendant state needs updating
         RemoveStaged(stage, false, MemPoolRemovalReason::SIZELIMIT);
         if (pvNoSpendsRemaining) {
             for (const CTransaction& tx : txn) {
@@ -1051,9 +1213,11 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
                 }
             }
         }
+        nUsage = DynamicMemoryUsage();
     }
 
     if (maxFeeRateRemoved > CFeeRate(0)) {
+        trackPackageRemoved(maxFeeRateRemoved);
         LogPrint(BCLog::MEMPOOL, "Removed %u txn, rolling minimum fee bumped to %s\n", nTxnRemoved, maxFeeRateRemoved.ToString());
     }
 }
@@ -1061,13 +1225,13 @@ void CTxMemPool::TrimToSize(size_t sizelimit, std::vector<COutPoint>* pvNoSpends
 uint64_t CTxMemPool::CalculateDescendantMaximum(txiter entry) const {
     // find parent with highest descendant count
     std::vector<txiter> candidates;
-    setEntries counted;
+    const EpochGuard epoch(*this);
     candidates.push_back(entry);
     uint64_t maximum = 0;
     while (candidates.size()) {
         txiter candidate = candidates.back();
         candidates.pop_back();
-        if (!counted.insert(candidate).second) continue;
+        if (visited(candidate)) continue;
         const setEntries& parents = GetMemPoolParents(candidate);
         if (parents.size() == 0) {
             maximum = std::max(maximum, candidate->GetCountWithDescendants());
@@ -1091,3 +1255,17 @@ void CTxMemPool::GetTransactionAncestry(const uint256& txid, size_t& ancestors,
 }
 
 SaltedTxidHasher::SaltedTxidHasher() : k0(GetRand(std::numeric_limits<uint64_t>::max())), k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+CTxMemPool::EpochGuard::EpochGuard(const CTxMemPool& in) : pool(in)
+{
+    assert(!pool.m_has_epoch_guard);
+    ++pool.m_epoch;
+    pool.m_has_epoch_guard = true;
+}
+
+CTxMemPool::EpochGuard::~EpochGuard()
+{
+    // prevents stale results being used
+    ++pool.m_epoch;
+    pool.m_has_epoch_guard = false;
+}
@@ -12,6 +12,7 @@
 #include <vector>
 #include <utility>
 #include <string>
+#include <tuple>
 
 #include <amount.h>
 #include <coins.h>
@@ -130,6 +131,7 @@ public:
     int64_t GetSigOpCostWithAncestors() const { return nSigOpCostWithAncestors; }
 
     mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
+    mutable uint64_t m_epoch; //!< epoch when last touched, useful for graph algorithms
 };
 
 // Helpers for modifying CTxMemPool::mapTx, which is a boost multi_index.
@@ -367,6 +369,34 @@ public:
     }
 };
 
+/** Key of the mempool script index: an output or a spent prevout of a transaction paying to a script */
+struct CMempoolScriptDeltaKey
+{
+    uint160 scriptHash; //!< Hash160 of the scriptPubKey
+    uint256 txhash;
+    uint32_t index;     //!< Output index, or input index when spending
+    bool spending;
+
+    CMempoolScriptDeltaKey(const uint160& script_hash, const uint256& hash, uint32_t n, bool fSpending) :
+        scriptHash(script_hash), txhash(hash), index(n), spending(fSpending) {}
+    explicit CMempoolScriptDeltaKey(const uint160& script_hash) : scriptHash(script_hash), index(0), spending(false) {}
+
+    friend bool operator<(const CMempoolScriptDeltaKey& a, const CMempoolScriptDeltaKey& b)
+    {
+        return std::tie(a.scriptHash, a.txhash, a.index, a.spending) < std::tie(b.scriptHash, b.txhash, b.index, b.spending);
+    }
+};
+
+struct CMempoolScriptDelta
+{
+    int64_t time;
+    CAmount amount;     //!< Negative when spending
+    COutPoint prevout;  //!< Spent outpoint, null for outputs
+
+    CMempoolScriptDelta(int64_t nTime, CAmount nAmount, const COutPoint& prevoutIn = COutPoint()) :
+        time(nTime), amount(nAmount), prevout(prevoutIn) {}
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -448,10 +478,13 @@ private:
 
     uint64_t totalTxSize;      //!< sum of all mempool tx's virtual sizes. Differs from serialized tx size since witness data is discounted. Defined in BIP 141.
     uint64_t cachedInnerUsage; //!< sum of dynamic memory usage of all the map elements (NOT the maps themselves)
+    uint64_t cachedScriptIndexUsage; //!< sum of dynamic memory usage of the mapScriptDeltasInserted elements
 
     mutable int64_t lastRollingFeeUpdate;
     mutable bool blockSinceLastRollingFeeBump;
     mutable double rollingMinimumFeeRate; //!< minimum fee to get into the pool, decreases exponentially
+    mutable uint64_t m_epoch;
+    mutable bool m_has_epoch_guard;
 
     void trackPackageRemoved(const CFeeRate& rate) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
@@ -553,6 +586,17 @@ private:
 
     std::vector<indexed_transaction_set::const_iterator> GetSortedDepthAndScore() const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    typedef std::map<CMempoolScriptDeltaKey, CMempoolScriptDelta> scriptDeltaMap;
+    scriptDeltaMap mapScriptDeltas GUARDED_BY(cs);
+    //! Script index keys of each indexed transaction, to remove them along with it
+    std::map<uint256, std::vector<CMempoolScriptDeltaKey>> mapScriptDeltasInserted GUARDED_BY(cs);
+
+    /** Index the scripts paid by the outputs and spent by the inputs of an
+     *  entry being added, resolving the spent coins from the pool and the
+     *  chain tip. */
+    void addScriptIndex(const CTxMemPoolEntry& entry) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
+    void removeScriptIndex(const uint256& txhash) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
 public:
     indirectmap<COutPoint, const CTransaction*> mapNextTx GUARDED_BY(cs);
     std::map<uint256, CAmount> mapDeltas;
@@ -580,6 +624,11 @@ public:
     void addUnchecked(const CTxMemPoolEntry& entry, bool validFeeEstimate = true) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
     void addUnchecked(const CTxMemPoolEntry& entry, setEntries& setAncestors, bool validFeeEstimate = true) EXCLUSIVE_LOCKS_REQUIRED(cs, cs_main);
 
+    /** Get the index entries of all mempool transactions touching the given scripts */
+    void getScriptIndex(const std::vector<CScript>& scripts, std::vector<std::pair<CMempoolScriptDeltaKey, CMempoolScriptDelta>>& results) const;
+    /** Get the scripts touched by an indexed mempool transaction */
+    void getScriptIndexScripts(const uint256& txhash, std::set<uint160>& scriptHashes) const;
+
     void removeRecursive(const CTransaction &tx, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
     void removeForReorg(const CCoinsViewCache *pcoins, unsigned int nMemPoolHeight, int flags) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
     void removeConflicts(const CTransaction &tx) EXCLUSIVE_LOCKS_REQUIRED(cs);
@@ -726,6 +775,9 @@ private:
     void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants) EXCLUSIVE_LOCKS_REQUIRED(cs);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry) EXCLUSIVE_LOCKS_REQUIRED(cs);
+    /** Share of DynamicMemoryUsage() freed by removing an entry. Links are
+     *  counted on both sides, as the linked entries' sets shrink too. */
+    size_t EntryDynamicMemoryUsage(txiter entry) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     /** Before calling removeUnchecked for a given transaction,
      *  UpdateForRemoveFromMempool must be called on the entire (dependent) set
@@ -736,6 +788,34 @@ private:
      *  removal.
      */
     void removeUnchecked(txiter entry, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+public:
+    /** EpochGuard: RAII-style guard for using epoch-based graph traversal algorithms.
+     *  When a new EpochGuard is created, all entries which were visited under
+     *  the previous epoch are considered unvisited again. Only one guard may
+     *  be alive at a time, and mempool.cs must be held for its lifetime.
+     *
+     *  Graph traversals use visited() to mark an entry and learn whether it
+     *  had already been reached in the current epoch, replacing the temporary
+     *  std::set<txiter> collections otherwise needed to deduplicate a walk.
+     */
+    class EpochGuard {
+        const CTxMemPool& pool;
+    public:
+        explicit EpochGuard(const CTxMemPool& in);
+        ~EpochGuard();
+        EpochGuard(const EpochGuard&) = delete;
+        EpochGuard& operator=(const EpochGuard&) = delete;
+    };
+
+    /** Mark an entry as visited in the current epoch and return whether it
+     *  had already been visited. Requires a live EpochGuard. */
+    bool visited(txiter it) const EXCLUSIVE_LOCKS_REQUIRED(cs) {
+        assert(m_has_epoch_guard);
+        bool ret = it->m_epoch >= m_epoch;
+        it->m_epoch = std::max(it->m_epoch, m_epoch);
+        return ret;
+    }
 };
 
 /**